@@ -36,6 +36,8 @@ REFERENCE:
 #ifndef T0_FRQ_METER
 	#include "../../int/timer0/T0FreqMeter.h"
 #endif
+
+#define TSC3200 1 // identifies that this library is already included
 /*---------------------------------------------------------------------------------------------*/
 
 
@@ -56,6 +56,8 @@ volatile uint8_t seqWrite[32]="Tuhin Sengupta"; // Dummy text
 #ifndef I2C
 	#include "../../int/i2c/i2c.h"
 #endif
+
+#define EXT_EEPROM 1 // identifies that this library is already included
 /*--------------------------------------------------------------------------*/
 
 
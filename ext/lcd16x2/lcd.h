@@ -59,6 +59,10 @@ me@avinashgupta.com
 #ifndef _LCD_H
 #define _LCD_H
 
+#ifndef FMT_HEX
+	#include "../../io/format.h"
+#endif
+
 
 
 /*_________________________________________________________________________________________*/
@@ -116,8 +120,10 @@ Uncomment Just one of them
 
 void LCDInit(uint8_t style);
 void LCDWriteString(const char *msg);
+void LCDWriteString_P(const char *msg);
 void LCDWriteInt(int val,unsigned int field_length);
 void LCDWriteLInt(int32_t val,unsigned int field_length);
+void LCDSink(uint8_t c);
 
 void LCDGotoXY(uint8_t x,uint8_t y);
 
@@ -148,6 +154,11 @@ void LCDBusyLoop();
  LCDWriteString(msg);\
 }
 
+#define LCDWriteStringXY_P(x,y,msg) {\
+ LCDGotoXY(x,y);\
+ LCDWriteString_P(msg);\
+}
+
 #define LCDWriteIntXY(x,y,val,fl) {\
  LCDGotoXY(x,y);\
  LCDWriteInt(val,fl);\
@@ -157,6 +168,9 @@ void LCDBusyLoop();
  LCDGotoXY(x,y);\
  LCDWriteLInt(val,fl);\
 }
+
+//printf like output at the cursor, see io/format.h
+#define LCDPrintf(fmt, ...) fmtPrint_P(LCDSink, PSTR(fmt), ##__VA_ARGS__)
 /***************************************************/
 
 
@@ -486,6 +500,49 @@ void LCDWriteString(const char *msg)
  }
 }
 
+void LCDWriteString_P(const char *msg)
+{
+	/*****************************************************************
+	
+	Same as LCDWriteString() but the string stays in flash and is read
+	from there byte by byte, it takes no SRAM.
+
+		LCDWriteString_P(PSTR("Temp is 30%0C"));
+
+	*****************************************************************/
+ char c;
+ while((c=pgm_read_byte(msg))!='\0')
+ {
+ 	//Custom Char Support
+	if(c=='%')
+	{
+		msg++;
+		c=pgm_read_byte(msg);
+		int8_t cc=c-'0';
+
+		if(cc>=0 && cc<=7)
+		{
+			LCDData(cc);
+		}
+		else if(c=='\0')
+		{
+			LCDData('%');	//'%' was the last char
+			return;
+		}
+		else
+		{
+			LCDData('%');
+			LCDData(c);
+		}
+	}
+	else
+	{
+		LCDData(c);
+	}
+	msg++;
+ }
+}
+
 void LCDWriteInt(int val,unsigned int field_length)
 {
 	/***************************************************************
@@ -497,26 +554,12 @@ void LCDWriteInt(int val,unsigned int field_length)
 	2)unsigned int field_length :total length of field in which the value is printed
 	must be between 1-5 if it is -1 the field length is no of digits in the val
 
-	****************************************************************/
+	The field is filled with leading '0'. A value longer than the field
+	is printed in full.
 
-	char str[5]={0,0,0,0,0};
-	int i=4,j=0;
-	while(val)
-	{
-	str[i]=val%10;
-	val=val/10;
-	i--;
-	}
-	if(field_length==-1)
-		while(str[j]==0) j++;
-	else
-		j=5-field_length;
+	****************************************************************/
 
-	if(val<0) LCDData('-');
-	for(i=j;i<5;i++)
-	{
-	LCDData(48+str[i]);
-	}
+	LCDWriteLInt(val,field_length);
 }
 
 void LCDWriteLInt(int32_t val,unsigned int field_length)
@@ -530,26 +573,31 @@ void LCDWriteLInt(int32_t val,unsigned int field_length)
 	2)unsigned int field_length :total length of field in which the value is printed
 	must be between 1-10 if it is -1 the field length is no of digits in the val
 
+	The digits come from fmtNumber() (io/format.h), no division.
+
 	****************************************************************/
 
-	char str[10]={0,0,0,0,0,0,0,0,0,0};
-	int i=9,j=0;
-	while(val)
+	uint8_t flags=0;
+	uint8_t width=0;
+	uint32_t mag=val;
+
+	if(val<0)
 	{
-	str[i]=val%10;
-	val=val/10;
-	i--;
+		flags|=FMT_NEG;
+		mag=-(uint32_t)val;
 	}
-	if(field_length==-1)
-		while(str[j]==0) j++;
-	else
-		j=10-field_length;
-
-	if(val<0) LCDData('-');
-	for(i=j;i<10;i++)
+	if(field_length!=(unsigned int)-1)
 	{
-	LCDData(48+str[i]);
+		flags|=FMT_ZERO;
+		width=field_length;
 	}
+	fmtNumber(LCDSink,mag,flags,width,0);
+}
+
+void LCDSink(uint8_t c)
+{
+	//One character at the cursor, for fmtPrint() and friends
+	LCDData(c);
 }
 
 void LCDGotoXY(uint8_t x,uint8_t y)
@@ -0,0 +1,494 @@
+/******************** DESCRIPTION ********************
+Packet link over cheap 433 Mhz OOK modules (TX: FS1000A and
+alike, RX: XY-MK-5V and alike). Sending plain USART bytes through
+them (see usart.h) needs slow rates and spacers, because the
+receiver's AGC and data slicer drift on long runs of 0 or 1 and
+the USART has nothing to resync on but the start bit.
+
+Here the bits are Manchester coded: each bit is two half bit
+"chips", 1 => high low, 0 => low high. Every bit has a
+transition in its middle and the line is high exactly half the
+time, whatever the data (DC balanced), so the slicer stays
+centred and the receiver clock can follow every bit.
+
+	PREAMBLE (RF_PREAMBLE bytes of 0xFF) | START 0xD3 | LEN | DATA[LEN] | CRCL CRCH
+
+	CRC-16 CCITT (avr-libc _crc_ccitt_update, start 0xFFFF) over
+	LEN and DATA, low byte first. Bytes go LSB first.
+
+A timer interrupts 8 times per chip. RX runs a digital PLL: a
+ramp counts through each chip and is pulled forward or back at
+every edge seen on the pin, so it locks onto the sender's clock
+during the preamble and stays locked through the packet. Each
+chip is the majority of its 8 samples. The receiver looks for
+the 16 chips of the start byte (they do not show up anywhere in
+the preamble, at any chip offset), which fixes bit and byte
+boundaries in one go. A chip pair that is not 10 or 01 is not
+Manchester, so noise mostly ends a packet at once.
+
+USER FUNCTIONS:
+	1. rfInit(); 					=> pins, timer, turns interrupts on
+	2. rfSend(data, len); 			=> queues one packet. Waits while the
+									   one before is still going out
+	3. rfTxBusy(); 					=> 1 while a packet is going out
+	4. rfAvailable(); 				=> packets received and not read yet
+	5. rfReceive(&pkt); 			=> takes the oldest packet. 0 if none
+									   pkt.len, pkt.data[]
+	6. rf.badCrc, rf.badLen,
+	   rf.badSymbol, rf.lost 		=> packets dropped and why
+
+NOTE:
+	Uses Timer0 or Timer2 (RF_TIMER) in CTC mode with its compare
+	match ISR. At 2000 bit/s it comes 32000 times a second, every
+	500 cycles at 16Mhz, and takes about 40 to 80 cycles.
+	The PLL follows a sender whose bit rate is upto about 3% off
+	(crystals and ceramic resonators are far better than that),
+	the internal RC oscillator may need calibrating.
+	Half duplex: RX is paused while a packet goes out, so a
+	receiver next to the sender does not hear its own packets.
+	The user data rate is RF_BITRATE / 8 bytes per second, the
+	cost per packet is RF_PREAMBLE + 4 bytes. Most modules
+	take 1000 to 4000 bit/s.
+----------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#undef YES
+#undef NO
+#define YES 1
+#define NO 2
+
+#define RF_T0 0
+#define RF_T2 2
+
+// receive states
+#define RF_HUNT 0		// looking for the start byte
+#define RF_LEN 1
+#define RF_DATA 2
+#define RF_CRCL 3
+#define RF_CRCH 4
+
+#define RF_START 0xD3
+#define RF_START_CHIPS 0xA59A	// 0xD3 LSB first, 1 => 10, 0 => 01, first chip at the top
+
+// PLL: the ramp runs 0..159 in one chip, 20 per sample. An edge
+// should come at the wrap. One seen in the first half of the
+// ramp means the ramp is ahead, it is held back, else pushed on
+#define RF_SAMPLES 8
+#define RF_RAMP_LEN 160
+#define RF_RAMP_INC (RF_RAMP_LEN / RF_SAMPLES)
+#define RF_RAMP_HALF (RF_RAMP_LEN / 2)
+#define RF_RAMP_ADJUST 9
+#define RF_RAMP_RETARD (RF_RAMP_INC - RF_RAMP_ADJUST)
+#define RF_RAMP_ADVANCE (RF_RAMP_INC + RF_RAMP_ADJUST)
+/*------------------------------------------------------*/
+
+
+
+/******************* USER CONFIGURABLE *******************/
+#define RF_TIMER RF_T2			// RF_T0 or RF_T2
+#define RF_BITRATE 2000			// data bits per second (chips are twice that)
+#define RF_PREAMBLE 6			// 0xFF bytes before the start byte
+#define RF_MAX_LEN 32			// data bytes of the longest packet, upto 251 - RF_PREAMBLE
+#define RF_RX_DEPTH 2			// packets kept till read. 2, 4, 8 ... 128
+
+#define RF_TX_DDR DDRB
+#define RF_TX_PORT PORTB
+#define RF_TX_POS PB0
+
+#define RF_RX_DDR DDRB
+#define RF_RX_PIN PINB
+#define RF_RX_POS PB1
+/*-------------------------------------------------------*/
+
+
+
+/********************* DEPENDENCY *********************/
+#ifndef RING_TYPE
+	#include "../../io/ring.h"
+#endif
+
+#include <util/crc16.h>
+
+// fewest CPU cycles per tick that leave the main loop some time
+#define RF_MIN_CYCLES 250
+
+// CPU cycles per tick, then the smallest prescaler that fits 8 bit
+#define RF_TICK_RATE_WANTED (2UL * RF_SAMPLES * RF_BITRATE)
+#define RF_CYCLES (F_CPU / RF_TICK_RATE_WANTED)
+
+#if RF_CYCLES < RF_MIN_CYCLES
+	#error RF_BITRATE TOO HIGH FOR THIS F_CPU
+#elif RF_CYCLES <= 256
+	#define RF_PRESCALER 1
+#elif RF_CYCLES <= 256UL * 8
+	#define RF_PRESCALER 8
+#elif RF_CYCLES <= 256UL * 64
+	#define RF_PRESCALER 64
+#elif RF_CYCLES <= 256UL * 256
+	#define RF_PRESCALER 256
+#else
+	#error RF_BITRATE TOO LOW FOR THIS F_CPU
+#endif
+
+#define RF_OCR ((F_CPU + RF_TICK_RATE_WANTED * RF_PRESCALER / 2) / (RF_TICK_RATE_WANTED * RF_PRESCALER) - 1)
+
+#if RF_TIMER == RF_T0
+	#if RF_PRESCALER == 1
+		#define RF_CS 1
+	#elif RF_PRESCALER == 8
+		#define RF_CS 2
+	#elif RF_PRESCALER == 64
+		#define RF_CS 3
+	#else
+		#define RF_CS 4
+	#endif
+#elif RF_TIMER == RF_T2
+	#if RF_PRESCALER == 1
+		#define RF_CS 1
+	#elif RF_PRESCALER == 8
+		#define RF_CS 2
+	#elif RF_PRESCALER == 64
+		#define RF_CS 4
+	#else
+		#define RF_CS 6
+	#endif
+#else
+	#error RF_TIMER MUST BE RF_T0 OR RF_T2
+#endif
+
+#if RF_PREAMBLE + 4 + RF_MAX_LEN > 255
+	#error RF_MAX_LEN MUST BE UPTO 251 - RF_PREAMBLE
+#endif
+
+#define RF_TX_SIZE (RF_PREAMBLE + 4 + RF_MAX_LEN)
+/*----------------------------------------------------*/
+
+
+
+/*********************** GLOBAL ***********************/
+struct rfPkt {
+	uint8_t len;
+	uint8_t data[RF_MAX_LEN];
+};
+
+RING_TYPE(rfPktRing, struct rfPkt, RF_RX_DEPTH)
+
+struct rf {
+	// TX
+	uint8_t txBuf[RF_TX_SIZE];	// whole packet, preamble to CRC
+	uint8_t txLen;
+	uint8_t txIndex;
+	uint8_t txByte;
+	uint8_t txBits;			// bits of txByte still to go
+	uint8_t txHalf;			// 1 => second chip of the bit
+	uint8_t txTick;			// ticks till the next chip
+	volatile uint8_t txBusy;
+
+	// RX PLL
+	uint8_t ramp;
+	uint8_t integ;			// high samples in this chip
+	uint8_t last;			// last sample
+	uint16_t chips;			// last 16 chips, newest at bit 0
+	uint8_t pairHalf;		// 1 => first chip of a bit is in
+	uint8_t rxByte;
+	uint8_t rxBits;
+
+	// RX packet
+	uint8_t state;
+	uint8_t index;
+	uint8_t crcLow;
+	uint16_t crc;
+	struct rfPkt cur;
+	struct rfPktRing rx;
+
+	volatile uint8_t badCrc;
+	volatile uint8_t badLen;
+	volatile uint8_t badSymbol;		// not Manchester after the start byte
+	volatile uint8_t lost;			// ring full
+} rf;
+/*----------------------------------------------------*/
+
+
+
+/*********************** INTERNALS ***********************/
+// one whole byte after the start byte
+static inline void rfRxByte(uint8_t byte) {
+	switch(rf.state) {
+		case RF_LEN:
+			if(byte > RF_MAX_LEN) {
+				rf.badLen++;
+				rf.state = RF_HUNT;
+				break;
+			}
+			rf.cur.len = byte;
+			rf.crc = _crc_ccitt_update(0xFFFF, byte);
+			rf.index = 0;
+			rf.state = byte ? RF_DATA : RF_CRCL;
+			break;
+
+		case RF_DATA:
+			rf.cur.data[rf.index++] = byte;
+			rf.crc = _crc_ccitt_update(rf.crc, byte);
+			if(rf.index == rf.cur.len) {
+				rf.state = RF_CRCL;
+			}
+			break;
+
+		case RF_CRCL:
+			rf.crcLow = byte;
+			rf.state = RF_CRCH;
+			break;
+
+		case RF_CRCH:
+			if(rf.crc != (((uint16_t)byte << 8) | rf.crcLow)) {
+				rf.badCrc++;
+			}
+			else if(!rfPktRingPush(&rf.rx, rf.cur)) {
+				rf.lost++;
+			}
+			rf.state = RF_HUNT;
+			break;
+	}
+}
+
+
+// one chip out of the PLL
+static inline void rfRxChip(uint8_t chip) {
+	uint8_t pair;
+	rf.chips = (rf.chips << 1) | chip;
+
+	if(rf.state == RF_HUNT) {
+		if(rf.chips == RF_START_CHIPS) {
+			rf.state = RF_LEN;
+			rf.pairHalf = 0;
+			rf.rxBits = 0;
+		}
+		return;
+	}
+
+	if(!rf.pairHalf) {
+		rf.pairHalf = 1;
+		return;
+	}
+	rf.pairHalf = 0;
+
+	pair = rf.chips & 3;
+	if(pair == 0 || pair == 3) {
+		rf.badSymbol++;
+		rf.state = RF_HUNT;
+		return;
+	}
+	rf.rxByte >>= 1;
+	if(pair == 2) { // 10 => 1
+		rf.rxByte |= 0x80;
+	}
+	if(++rf.rxBits == 8) {
+		rf.rxBits = 0;
+		rfRxByte(rf.rxByte);
+	}
+}
+
+
+static inline void rfRxTick(uint8_t sample) {
+	rf.integ += sample;
+	if(sample != rf.last) {
+		rf.ramp += rf.ramp < RF_RAMP_HALF ? RF_RAMP_RETARD : RF_RAMP_ADVANCE;
+		rf.last = sample;
+	}
+	else {
+		rf.ramp += RF_RAMP_INC;
+	}
+	if(rf.ramp >= RF_RAMP_LEN) {
+		rf.ramp -= RF_RAMP_LEN;
+		rfRxChip(rf.integ > RF_SAMPLES / 2);
+		rf.integ = 0;
+	}
+}
+
+
+static inline void rfTxTick(void) {
+	uint8_t chip;
+	if(rf.txTick) {
+		rf.txTick--;
+		return;
+	}
+	rf.txTick = RF_SAMPLES - 1;
+
+	if(!rf.txHalf) {
+		if(!rf.txBits) {
+			if(rf.txIndex == rf.txLen) {
+				// all out. Carrier off, RX listens again
+				RF_TX_PORT &= ~(1<<RF_TX_POS);
+				rf.state = RF_HUNT;
+				rf.txBusy = 0;
+				return;
+			}
+			rf.txByte = rf.txBuf[rf.txIndex++];
+			rf.txBits = 8;
+		}
+		chip = rf.txByte & 1;	// 1 => high first
+	}
+	else {
+		chip = !(rf.txByte & 1);
+		rf.txByte >>= 1;
+		rf.txBits--;
+	}
+	rf.txHalf = !rf.txHalf;
+
+	if(chip) {
+		RF_TX_PORT |= (1<<RF_TX_POS);
+	}
+	else {
+		RF_TX_PORT &= ~(1<<RF_TX_POS);
+	}
+}
+/*-------------------------------------------------------*/
+
+
+
+/******************* USER FUNCTIONS *******************/
+void rfInit() {
+	cli();
+	rfPktRingInit(&rf.rx);
+	rf.txBusy = 0;
+	rf.state = RF_HUNT;
+	rf.ramp = 0;
+	rf.integ = 0;
+	rf.badCrc = 0;
+	rf.badLen = 0;
+	rf.badSymbol = 0;
+	rf.lost = 0;
+
+	RF_TX_PORT &= ~(1<<RF_TX_POS); // carrier off
+	RF_TX_DDR |= (1<<RF_TX_POS);
+	RF_RX_DDR &= ~(1<<RF_RX_POS);
+
+	#if RF_TIMER == RF_T0
+		TCCR0 = (1<<WGM01) | RF_CS; // CTC
+		TCNT0 = 0;
+		OCR0 = RF_OCR;
+		TIFR = (1<<OCF0);
+		TIMSK |= (1<<OCIE0);
+	#else
+		TCCR2 = (1<<WGM21) | RF_CS; // CTC
+		TCNT2 = 0;
+		OCR2 = RF_OCR;
+		TIFR = (1<<OCF2);
+		TIMSK |= (1<<OCIE2);
+	#endif
+	sei();
+}
+
+
+#define rfTxBusy() (rf.txBusy)
+
+
+void rfSend(const void *data, uint8_t len) {
+	const uint8_t *src = data;
+	uint16_t crc;
+	uint8_t n = 0;
+	uint8_t i;
+
+	if(len > RF_MAX_LEN) {
+		len = RF_MAX_LEN;
+	}
+	while(rf.txBusy);
+
+	for(i=0; i<RF_PREAMBLE; i++) {
+		rf.txBuf[n++] = 0xFF; // chips 1010..., the PLL locks on these
+	}
+	rf.txBuf[n++] = RF_START;
+	rf.txBuf[n++] = len;
+	crc = _crc_ccitt_update(0xFFFF, len);
+	for(i=0; i<len; i++) {
+		rf.txBuf[n++] = src[i];
+		crc = _crc_ccitt_update(crc, src[i]);
+	}
+	rf.txBuf[n++] = crc & 0xFF;
+	rf.txBuf[n++] = crc >> 8;
+
+	rf.txLen = n;
+	rf.txIndex = 0;
+	rf.txBits = 0;
+	rf.txHalf = 0;
+	rf.txTick = 0;
+	rf.txBusy = 1; // the ISR takes over from here
+}
+
+
+#define rfAvailable() rfPktRingCount(&rf.rx)
+#define rfReceive(pkt) rfPktRingPop(&rf.rx, (pkt))
+/*-----------------------------------------------------*/
+
+
+
+/************************* ISR *************************/
+#if RF_TIMER == RF_T0
+	#ifdef ISR_DISPATCH
+		#define ISR_CLAIM_TIMER0_COMP
+		#include "../../int/isr/isrClaim.h"
+		SHARED_ISR
+	#else
+		ISR(TIMER0_COMP_vect)
+	#endif
+#else
+	#ifdef ISR_DISPATCH
+		#define ISR_CLAIM_TIMER2_COMP
+		#include "../../int/isr/isrClaim.h"
+		SHARED_ISR
+	#else
+		ISR(TIMER2_COMP_vect)
+	#endif
+#endif
+{
+	// pin first, so the sample point does not move with the work
+	uint8_t sample = (RF_RX_PIN >> RF_RX_POS) & 1;
+
+	if(rf.txBusy) {
+		rfTxTick();
+	}
+	else {
+		rfRxTick(sample);
+	}
+}
+/*-----------------------------------------------------*/
+
+
+
+/******************* EXAMPLE CODE *******************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/ext/rf433/rfLink.h"
+#include "mega16/ext/lcd16x2/lcd.h"
+
+// both ends run the same code: every second a counter goes out,
+// whatever comes in is shown on the LCD
+int main() {
+	struct rfPkt pkt;
+	uint16_t count = 0;
+	uint8_t i = 0;
+
+	LCDInit(LS_NONE);
+	LCDClear();
+	rfInit();
+
+	while(1) {
+		while(rfReceive(&pkt)) {
+			if(pkt.len == 2) {
+				LCDWriteIntXY(0, 0, pkt.data[0] | (pkt.data[1] << 8), 5);
+			}
+		}
+		LCDWriteIntXY(0, 1, rf.badCrc, 3);
+
+		if(++i == 100) {
+			i = 0;
+			count++;
+			rfSend(&count, 2);
+		}
+		_delay_ms(10);
+	}
+}
+-----------------------------------------------------*/
@@ -50,6 +50,8 @@ e.g.: struct ultrasound us0; (global scope)
 #ifndef T0_FRQ_METER
 	#include "../../int/timer0/T0FreqMeter.h"
 #endif
+
+#define HCSR04 1 // identifies that this library is already included
 /*---------------------------------------------------------------------------------------------*/
 
 
@@ -20,6 +20,20 @@ USER FUNCTIONS:
 	ReadADC	=> Pool single channel, Takes channel number as argument
 	adcInterruptEnable() => Enables ADC interrupt
 
+	If "ADC_CONV_CALLBACK" is "YES" then "void adc_callback(void)" is
+	called in free running mode after every conversion, once the result
+	is in adcResults[]. It has to be defined by the programmer or else the
+	library WILL NOT COMPILE.
+
+	adcResults[] only keeps the latest result of every channel. If
+	"ADC_SAMPLE_RING" is "YES" every conversion also goes into a ring
+	(ADC_RING_DEPTH samples), so a main loop that is late does not
+	miss samples:
+		adcAvailable() => samples waiting
+		adcRead(&sample) => takes the oldest (sample.ch, sample.value),
+							0 if none
+		adc.lost => samples dropped because the ring was full
+
 ---------------------------------------------------------------------------------*/
 
 
@@ -51,6 +65,9 @@ USER FUNCTIONS:
 
 /************************* USER CONFIGURABLE *************************/
 #define IS_FREE_RUNNING YES
+#define ADC_CONV_CALLBACK NO	// YES calls adc_callback() after every conversion (free running)
+#define ADC_SAMPLE_RING NO		// YES keeps every conversion in a ring (free running)
+#define ADC_RING_DEPTH 16		// samples in the ring. 2, 4, 8 ... 128
 
 
 #if IS_FREE_RUNNING == YES
@@ -61,11 +78,37 @@ USER FUNCTIONS:
 
 
 
+/***************************** DEPENDENCY ****************************/
+#ifndef ISR_PROF_SLOTS
+	#include "../isr/isrProfile.h"
+#endif
+
+#if IS_FREE_RUNNING == YES && ADC_SAMPLE_RING == YES
+	#ifndef RING_TYPE
+		#include "../../io/ring.h"
+	#endif
+#endif
+/*-------------------------------------------------------------------*/
+
+
+
 /****************************** GLOBAL *******************************/
 #if IS_FREE_RUNNING == YES
+	#if ADC_SAMPLE_RING == YES
+		struct adcSample {
+			uint8_t ch;		// mux channel
+			uint16_t value;
+		};
+		RING_TYPE(adcRing, struct adcSample, ADC_RING_DEPTH)
+	#endif
+
 	struct adc{
 		volatile uint8_t muxIndexLen;
 		volatile uint8_t currMuxIndexIndex;
+		#if ADC_SAMPLE_RING == YES
+			struct adcRing samples;
+			volatile uint8_t lost;
+		#endif
 	} adc;
 
 	// all the results are stored here in free running mode
@@ -84,6 +127,10 @@ void initADC(uint8_t refVoltage) {
 		// set mux
 		adc.muxIndexLen = sizeof(muxIndex)/sizeof(uint8_t);
 		adc.currMuxIndexIndex = 255; // not yet set condition
+		#if ADC_SAMPLE_RING == YES
+			adcRingInit(&adc.samples);
+			adc.lost = 0;
+		#endif
  	#endif
 
 	// turn the ADC om
@@ -152,6 +199,12 @@ uint16_t ReadADC(uint8_t ch){
 }
 
 
+#if IS_FREE_RUNNING == YES && ADC_SAMPLE_RING == YES
+	#define adcAvailable() adcRingCount(&adc.samples)
+	#define adcRead(sample) adcRingPop(&adc.samples, (sample))
+#endif
+
+
 // enable adc interrupt
 #define adcInterruptEnable() (ADCSRA |= (1<<ADIE))  // ISR(ADC_vect)	
 /* ------------------------------------------------------------------*/
@@ -159,12 +212,39 @@ uint16_t ReadADC(uint8_t ch){
 
 
 
+/***************************** PROTOTYPE *****************************/
+#if IS_FREE_RUNNING == YES && ADC_CONV_CALLBACK == YES
+	void adc_callback(void);
+#endif
+/*-------------------------------------------------------------------*/
+
+
+
+
 /******************************** ISR ********************************/
 #if IS_FREE_RUNNING == YES
-	ISR(ADC_vect) {
+	#ifdef ISR_DISPATCH
+		#define ISR_CLAIM_ADC
+		#include "../isr/isrClaim.h"
+		SHARED_ISR
+	#else
+		ISR(ADC_vect)
+	#endif
+	{
+		ISR_PROF_ENTER(ISR_PROF_ADC);
 		
 		// read and store recent conversion result
-		adcResults[muxIndex[adc.currMuxIndexIndex]] = ADC;
+		#if ADC_SAMPLE_RING == YES
+			struct adcSample sample;
+			sample.ch = muxIndex[adc.currMuxIndexIndex];
+			sample.value = ADC;
+			adcResults[sample.ch] = sample.value;
+			if(!adcRingPush(&adc.samples, sample)) {
+				adc.lost++;
+			}
+		#else
+			adcResults[muxIndex[adc.currMuxIndexIndex]] = ADC;
+		#endif
 		
 		// clear admux 
 		ADMUX &= ~(31); 
@@ -178,8 +258,13 @@ uint16_t ReadADC(uint8_t ch){
 		}
 		ADMUX |= muxIndex[adc.currMuxIndexIndex];
 
+		#if ADC_CONV_CALLBACK == YES
+			adc_callback();
+		#endif
+
 		_delay_us(15);
 		ADCSRA |= (1<<ADSC);
+		ISR_PROF_EXIT(ISR_PROF_ADC);
 	}
 #endif
 /*-------------------------------------------------------------------*/
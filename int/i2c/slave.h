@@ -9,6 +9,13 @@ USAGE:
     address, It will receive data from slave and store it in slave_recv[] buffer.
     and then it will send whatever's there in buffer slave_tran[]. 
 
+    slave_recv[] is written again by the next query. Every received byte
+    is also put in a ring (SLAVE_RX_DEPTH bytes), so a main loop that is
+    late still gets all of them, in order:
+        i2cSlaveAvailable();    => bytes waiting
+        i2cSlaveRead(&byte);    => takes the oldest, 0 if none
+        i2cSlaveLost            => bytes dropped because the ring was full
+
 
 
 NOTE: 
@@ -24,6 +31,14 @@ NOTE:
     #include "i2c.h"
 #endif
 
+#ifndef RING_TYPE
+	#include "../../io/ring.h"
+#endif
+
+#ifndef ISR_PROF_SLOTS
+	#include "../isr/isrProfile.h"
+#endif
+
 #undef YES
 #undef NO
 #define YES 1
@@ -38,6 +53,7 @@ NOTE:
 #define BUFLEN_RECV 12
 #define BUFLEN_TRAN 3
 #define I2C_EXC_DONE_CALLBACK NO
+#define SLAVE_RX_DEPTH 16 // received bytes kept till read. 2, 4, 8 ... 128
 // callback prototype.  Programmer can define chanege IO arguments here. 
 void i2cExchangeCompleteCallback(void);
 /*----------------------------------------------------------------------------------------------------*/
@@ -51,6 +67,10 @@ volatile uint8_t slave_recv[BUFLEN_RECV]; //buffer to store received bytes
 
 volatile uint8_t slave_t_index=0;
 volatile uint8_t slave_tran[BUFLEN_TRAN] = {0x12, 0x34, 0x56};  // This buffer is sent
+
+RING_TYPE(slaveRxRing, uint8_t, SLAVE_RX_DEPTH)
+struct slaveRxRing slaveRx; // all received bytes, oldest first
+volatile uint8_t i2cSlaveLost = 0;
 /*---------------------------------------------------------------------------------------------------*/
 
 
@@ -59,12 +79,17 @@ volatile uint8_t slave_tran[BUFLEN_TRAN] = {0x12, 0x34, 0x56};  // This buffer i
 
 /******************************************* USER FUNCTIONS *******************************************/
 void initSlave(uint8_t address) {
+    slaveRxRingInit(&slaveRx);
     sei();
     TWAR = (address<<1); //we're using address 0x01
     TWCR = (1<<TWEN)|(1<<TWEA)|(1<<TWIE);
 }   
 
 
+#define i2cSlaveAvailable() slaveRxRingCount(&slaveRx)
+#define i2cSlaveRead(byte) slaveRxRingPop(&slaveRx, (byte))
+
+
 void i2cSlaveHandle() {
     switch(TW_STATUS){
 //--------------Slave receiver------------------------------------
@@ -79,6 +104,9 @@ void i2cSlaveHandle() {
                     //setup the buffer to recieve another
             slave_recv[slave_r_index] = TWDR;
             slave_r_index++;
+            if(!slaveRxRingPush(&slaveRx, TWDR)) {
+                i2cSlaveLost++;
+            }
             //don't ack next data if buffer is full
             if(slave_r_index >= BUFLEN_RECV){
               TWI_TRANSFER(); // Do not send ACK
@@ -157,8 +185,17 @@ void i2cSlaveHandle() {
 
 
 
-ISR(TWI_vect) {  // Interrupt service routine
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_TWI
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(TWI_vect)
+#endif
+{  // Interrupt service routine
+	ISR_PROF_ENTER(ISR_PROF_TWI);
     i2cSlaveHandle();
+	ISR_PROF_EXIT(ISR_PROF_TWI);
 }
 /*----------------------------------------------------------------------------------------------------*/
 
@@ -0,0 +1,274 @@
+/******************** DESCRIPTION ********************
+Deferred procedure calls. A hardware ISR should only grab its
+data and leave. The slow part (parsing, LCD, maths) is posted
+here as a (handler, argument) pair and runs a little later with
+interrupts enabled, so other ISRs are not held up by it.
+
+Posts are kept in DPC_LEVELS queues. Level 0 is the most urgent.
+Every time one call is done the queues are searched again from
+level 0, so an urgent post overtakes the ones already waiting
+on lower levels. Calls of the same level run in order of post.
+
+The queues are drained from an interrupt vector nobody else
+uses, so no INT pin is wasted as in softIntr.h. The SPM ready
+(and EEPROM ready) interrupt fires for as long as its enable
+bit is set, so setting the bit works as a software interrupt.
+SPM_RDY is the last vector of the mega16, which makes it the
+lowest priority of all.
+
+USER FUNCTIONS:
+	1. dpcInit(); 					=> empties the queues
+	2. dpcPostISR(1, handler, arg); => post from inside an ISR
+	3. dpcPost(1, handler, arg); 	=> post from main (or anywhere)
+	4. dpcRun(); 					=> runs all pending calls right here
+	5. dpcPending(); 				=> non zero if something is queued
+
+	handler is "void handler(uint16_t arg)". Both post functions
+	return 1 on success and 0 if the queue of that level is full.
+	Lost posts are counted in dpc.dropped.
+
+DRAIN OPTIONS:
+	DPC_SPM 	=> SPM_RDY vector (default). Do not use with a boot loader
+				   that writes flash while the application runs.
+	DPC_EEPROM 	=> EE_RDY vector. Calls wait while an EEPROM write
+				   is in progress (upto 8.5ms).
+	DPC_POLL 	=> no vector. main() calls dpcRun() in its loop.
+
+	dpcRun() may also be called as the last line of an ISR. The
+	calls then run at ISR exit, with interrupts enabled again.
+
+NOTE:
+	dpcPostISR() needs interrupts to be disabled, which they are
+	inside any normal ISR. A handler runs with interrupts on, so
+	when it posts again it has to use dpcPost(), never
+	dpcPostISR(), else the ring is broken.
+	A handler runs with interrupts on, so data it shares with an
+	ISR has to be protected as usual.
+----------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#define DPC_SPM 1
+#define DPC_EEPROM 2
+#define DPC_POLL 3
+/*------------------------------------------------------*/
+
+
+
+/******************* USER CONFIGURABLE *******************/
+#define DPC_DRAIN DPC_SPM	// options are DPC_SPM, DPC_EEPROM, DPC_POLL
+#define DPC_LEVELS 3		// priority levels, 0 is the highest
+#define DPC_QUEUE_LEN 8		// calls per level. 2, 4, 8 ... 128
+/*-------------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#if (DPC_QUEUE_LEN & (DPC_QUEUE_LEN - 1)) || DPC_QUEUE_LEN > 128
+	#error DPC_QUEUE_LEN MUST BE A POWER OF 2 UPTO 128
+#endif
+
+#define DPC_WRAP (DPC_QUEUE_LEN - 1)
+
+#if DPC_DRAIN == DPC_SPM
+	#define dpcArm() (SPMCR |= (1<<SPMIE))
+	#define dpcDisarm() (SPMCR &= ~(1<<SPMIE))
+#elif DPC_DRAIN == DPC_EEPROM
+	#define dpcArm() (EECR |= (1<<EERIE))
+	#define dpcDisarm() (EECR &= ~(1<<EERIE))
+#else
+	#define dpcArm()
+	#define dpcDisarm()
+#endif
+/*------------------------------------------------------*/
+
+
+
+/************************* GLOBAL *************************/
+typedef void (*dpcHandler)(uint16_t arg);
+
+struct dpcItem {
+	dpcHandler handler;
+	uint16_t arg;
+};
+
+struct dpcLevel {
+	volatile struct dpcItem item[DPC_QUEUE_LEN];
+	volatile uint8_t head;	// written by the posting side only
+	volatile uint8_t tail;	// written by the draining side only
+};
+
+struct dpc {
+	struct dpcLevel level[DPC_LEVELS];
+	volatile uint8_t running;	// a drain is in progress
+	volatile uint8_t dropped;	// posts lost to a full queue
+} dpc;
+/*--------------------------------------------------------*/
+
+
+
+/******************* USER FUNCTIONS *******************/
+void dpcInit() {
+	uint8_t i;
+	cli();
+	for(i=0; i<DPC_LEVELS; i++) {
+		dpc.level[i].head = 0;
+		dpc.level[i].tail = 0;
+	}
+	dpc.running = 0;
+	dpc.dropped = 0;
+	dpcDisarm();
+	sei();
+}
+
+
+// interrupts must be off. No locking needed as ISRs do not nest
+uint8_t dpcPostISR(uint8_t level, dpcHandler handler, uint16_t arg) {
+	struct dpcLevel *q = &dpc.level[level];
+	uint8_t head = q->head;
+	uint8_t next = (head + 1) & DPC_WRAP;
+
+	if(next == q->tail) {
+		dpc.dropped++;
+		return 0;
+	}
+	q->item[head].handler = handler;
+	q->item[head].arg = arg;
+	q->head = next; // item is complete before it becomes visible
+	dpcArm();
+	return 1;
+}
+
+
+uint8_t dpcPost(uint8_t level, dpcHandler handler, uint16_t arg) {
+	uint8_t sreg = SREG;
+	uint8_t ok;
+	cli();
+	ok = dpcPostISR(level, handler, arg);
+	SREG = sreg;
+	return ok;
+}
+
+
+uint8_t dpcPending() {
+	uint8_t i;
+	for(i=0; i<DPC_LEVELS; i++) {
+		if(dpc.level[i].head != dpc.level[i].tail) {
+			return 1;
+		}
+	}
+	return 0;
+}
+/*-----------------------------------------------------*/
+
+
+
+/*********************** INTERNALS ***********************/
+// runs calls until all levels are empty. Highest level first
+static inline void dpcDrain() {
+	uint8_t i = 0;
+	while(i < DPC_LEVELS) {
+		struct dpcLevel *q = &dpc.level[i];
+		uint8_t tail = q->tail;
+		if(tail == q->head) {
+			i++;
+			continue;
+		}
+		dpcHandler handler = q->item[tail].handler;
+		uint16_t arg = q->item[tail].arg;
+		q->tail = (tail + 1) & DPC_WRAP;
+		handler(arg);
+		i = 0; // a call may have posted something more urgent
+	}
+}
+/*-------------------------------------------------------*/
+
+
+
+/******************* USER FUNCTIONS *******************/
+void dpcRun() {
+	uint8_t sreg = SREG;
+	cli();
+	if(dpc.running) {
+		SREG = sreg; // already being drained further down the stack
+		return;
+	}
+	dpc.running = 1;
+	dpcDisarm();
+	sei();
+	dpcDrain();
+	cli();
+	dpc.running = 0;
+	if(dpcPending()) {
+		dpcArm(); // posted between the last check and cli()
+	}
+	SREG = sreg;
+}
+/*-----------------------------------------------------*/
+
+
+
+/************************* ISR *************************/
+#if DPC_DRAIN == DPC_SPM
+	ISR(SPM_RDY_vect)
+#elif DPC_DRAIN == DPC_EEPROM
+	ISR(EE_RDY_vect)
+#endif
+#if DPC_DRAIN != DPC_POLL
+{
+	dpcDisarm();
+	if(dpc.running) {
+		return; // nested on top of a drain, that one picks it up
+	}
+	dpc.running = 1;
+	sei();
+	dpcDrain();
+	cli();
+	dpc.running = 0;
+	if(dpcPending()) {
+		dpcArm(); // fires again right after reti
+	}
+}
+#endif
+/*-----------------------------------------------------*/
+
+
+
+/******************* EXAMPLE CODE *******************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/int/intr/dpc.h"
+#include "mega16/int/intr/int0.h"
+#include "mega16/ext/lcd16x2/lcd.h"
+
+volatile uint8_t presses;
+
+// slow part, runs after the INT0 ISR has returned
+void showPresses(uint16_t count) {
+	LCDWriteIntXY(0,0,count,3);
+}
+
+void blink(uint16_t mask) {
+	PORTA ^= (uint8_t)mask;
+}
+
+// INT0 ISR only counts and posts
+void int0_Callback() {
+	presses++;
+	dpcPostISR(1, showPresses, presses);
+	dpcPostISR(0, blink, (1<<PA7)); // runs before the LCD update
+}
+
+int main() {
+	DDRA |= (1<<PA7);
+	LCDInit(LS_NONE);
+	LCDClear();
+	dpcInit();
+	int0Init();
+
+	while(1) {
+	}
+}
+-----------------------------------------------------*/
@@ -19,6 +19,9 @@
 		The function "int0_Callback()" has to be defined
 		by the programmer,  Otherwise the library WILL NOT COMPILE
 
+		For fast edge trains (IR, encoders) where the callback
+		would be too slow, see "intCapture.h".
+
 	
 ----------------------------------------------------*/
 
@@ -92,7 +95,14 @@ void int0_Callback(void);
 /*-------------------------------------------------------*/
 
 
-ISR (INT0_vect) {
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_INT0
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(INT0_vect)
+#endif
+{
 	int0_Callback();
 	GIFR |= (1<<INTF0); // clear the flag by writing 1 to it. This clear any other 
 }						// interrupt request might had come during ISR execution
@@ -19,6 +19,9 @@
 		The function "int1_Callback()" has to be defined
 		by the programmer,  Otherwise the library WILL NOT COMPILE
 
+		For fast edge trains (IR, encoders) where the callback
+		would be too slow, see "intCapture.h".
+
 	
 ----------------------------------------------------*/
 
@@ -89,7 +92,14 @@ void int1_Callback(void);
 /*-------------------------------------------------------*/
 
 
-ISR (INT1_vect) {
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_INT1
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(INT1_vect)
+#endif
+{
 	int1_Callback();
 	GIFR |= (1<<INTF1); // clear the flag by writing 1 to it. This clear any other 
 }						// interrupt request might had come during ISR execution
@@ -17,6 +17,9 @@
 		The function "int2_Callback()" has to be defined
 		by the programmer,  Otherwise the library WILL NOT COMPILE
 
+		For fast edge trains (IR, encoders) where the callback
+		would be too slow, see "intCapture.h".
+
 	
 ----------------------------------------------------*/
 
@@ -78,7 +81,14 @@ void int2_Callback(void);
 /*-------------------------------------------------------*/
 
 
-ISR (INT2_vect) {
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_INT2
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(INT2_vect)
+#endif
+{
 	int2_Callback();
 	GIFR |= (1<<INTF2); // clear the flag by writing 1 to it. This clear any other 
 }						// interrupt request might had come during ISR execution
@@ -0,0 +1,299 @@
+/******************** DESCRIPTION ********************
+Edge capture on INT0, INT1 and INT2. int0.h, int1.h and int2.h
+run a callback on every edge, which is too slow once the edges
+come fast (IR remotes, encoders, RF data). Here the ISR does
+nothing but note down when the edge came and which way it went.
+The main loop takes the edges out later and decodes them.
+
+Every edge gives one entry in a ring shared by the three pins:
+	stamp	=> TCNT1, Timer1 free running at 2 Mhz (0.5us @ 16Mhz)
+	source	=> INTCAP_INT0, INTCAP_INT1, INTCAP_INT2
+	level	=> pin level right after the edge (1 => rising edge)
+
+The ISR body is about 20 cycles. Both edges are captured, INT0
+and INT1 in "any change" mode, INT2 by flipping its edge select
+(ISC2) at every edge.
+
+USER FUNCTIONS:
+	1. intCapInit(); 				=> starts Timer1 and the enabled INTx
+	2. intCapAvailable(); 			=> edges waiting in the ring
+	3. intCapRead(&edge); 			=> takes the oldest edge. 0 if none
+	4. intCapFlush(); 				=> throws away all edges
+	5. intCap.lost 					=> edges dropped because the ring was full
+
+NOTE:
+	Timer1 is shared with T1Servo.h, logicTrace.h and pt.h (all
+	free running), other Timer1 modes do not work alongside.
+	A stamp rolls over every 65536 ticks (32.7ms @ 16Mhz). The
+	difference of two stamps is right as long as the edges are
+	less than that apart.
+	An INTx pin used here can not be used by int0.h, int1.h or
+	int2.h at the same time (unless isrDispatch.h is used).
+	INT2 needs a pulse of at least 50ns and the ISR to run before
+	the next edge, a glitch shorter than the ISR latency can make
+	it miss one edge.
+----------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#undef YES
+#undef NO
+#define YES 1
+#define NO 2
+
+#define INTCAP_INT0 0
+#define INTCAP_INT1 1
+#define INTCAP_INT2 2
+/*------------------------------------------------------*/
+
+
+
+/******************* USER CONFIGURABLE *******************/
+#define INTCAP_USE_INT0 YES		// PD2
+#define INTCAP_USE_INT1 NO		// PD3
+#define INTCAP_USE_INT2 NO		// PB2
+#define INTCAP_PULL_UP YES		// internal pull ups on the used pins
+#define INTCAP_DEPTH 32			// edges in the ring. 2, 4, 8 ... 128
+/*-------------------------------------------------------*/
+
+
+
+/********************* DEPENDENCY *********************/
+#ifndef T1_PRESCALER_NONE
+	#include "../timer1/timer1.h"
+#endif
+
+#if (INTCAP_DEPTH & (INTCAP_DEPTH - 1)) || INTCAP_DEPTH > 128
+	#error INTCAP_DEPTH MUST BE A POWER OF 2 UPTO 128
+#endif
+#define INTCAP_WRAP (INTCAP_DEPTH - 1)
+/*----------------------------------------------------*/
+
+
+
+/*********************** GLOBAL ***********************/
+struct intCapEdge {
+	uint16_t stamp;
+	uint8_t source;
+	uint8_t level;
+};
+
+struct intCap {
+	volatile uint16_t stamp[INTCAP_DEPTH];
+	volatile uint8_t flags[INTCAP_DEPTH];	// source<<1 | level
+	volatile uint8_t head;
+	volatile uint8_t tail;
+	volatile uint8_t lost;
+} intCap;
+/*----------------------------------------------------*/
+
+
+
+/******************* USER FUNCTIONS *******************/
+void intCapInit() {
+	cli();
+	intCap.head = 0;
+	intCap.tail = 0;
+	intCap.lost = 0;
+	T1freeRunStart();
+
+	#if INTCAP_USE_INT0 == YES
+		DDRD &= ~(1<<PD2);
+		#if INTCAP_PULL_UP == YES
+			PORTD |= (1<<PD2);
+		#endif
+		MCUCR = (MCUCR & ~(3<<ISC00)) | (1<<ISC00); // any change
+		GIFR = (1<<INTF0);
+		GICR |= (1<<INT0);
+	#endif
+
+	#if INTCAP_USE_INT1 == YES
+		DDRD &= ~(1<<PD3);
+		#if INTCAP_PULL_UP == YES
+			PORTD |= (1<<PD3);
+		#endif
+		MCUCR = (MCUCR & ~(3<<ISC10)) | (1<<ISC10); // any change
+		GIFR = (1<<INTF1);
+		GICR |= (1<<INT1);
+	#endif
+
+	#if INTCAP_USE_INT2 == YES
+		DDRB &= ~(1<<PB2);
+		#if INTCAP_PULL_UP == YES
+			PORTB |= (1<<PB2);
+		#endif
+		GICR &= ~(1<<INT2); // ISC2 may only change with INT2 off
+		if(PINB & (1<<PB2)) {
+			MCUCSR &= ~(1<<ISC2); // high now, wait for falling
+		}
+		else {
+			MCUCSR |= (1<<ISC2);
+		}
+		GIFR = (1<<INTF2);
+		GICR |= (1<<INT2);
+	#endif
+	sei();
+}
+
+
+uint8_t intCapAvailable() {
+	return (intCap.head - intCap.tail) & INTCAP_WRAP;
+}
+
+
+uint8_t intCapRead(struct intCapEdge *edge) {
+	uint8_t tail = intCap.tail;
+	uint8_t flags;
+	if(tail == intCap.head) {
+		return 0;
+	}
+	// slot is not written again before tail moves on
+	edge->stamp = intCap.stamp[tail];
+	flags = intCap.flags[tail];
+	edge->source = flags >> 1;
+	edge->level = flags & 1;
+	intCap.tail = (tail + 1) & INTCAP_WRAP;
+	return 1;
+}
+
+
+void intCapFlush() {
+	intCap.tail = intCap.head;
+}
+/*-----------------------------------------------------*/
+
+
+
+/*********************** INTERNALS ***********************/
+static inline void intCapStore(uint8_t flags) __attribute__((always_inline));
+static inline void intCapStore(uint8_t flags) {
+	uint16_t now = TCNT1;
+	uint8_t head = intCap.head;
+	uint8_t next = (head + 1) & INTCAP_WRAP;
+	if(next == intCap.tail) {
+		intCap.lost++;
+		return;
+	}
+	intCap.stamp[head] = now;
+	intCap.flags[head] = flags;
+	intCap.head = next;
+}
+/*-------------------------------------------------------*/
+
+
+
+/************************* ISR *************************/
+#if INTCAP_USE_INT0 == YES
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_INT0
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(INT0_vect)
+#endif
+{
+	uint8_t flags = INTCAP_INT0<<1;
+	if(PIND & (1<<PD2)) {
+		flags |= 1;
+	}
+	intCapStore(flags);
+}
+#endif
+
+
+#if INTCAP_USE_INT1 == YES
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_INT1
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(INT1_vect)
+#endif
+{
+	uint8_t flags = INTCAP_INT1<<1;
+	if(PIND & (1<<PD3)) {
+		flags |= 1;
+	}
+	intCapStore(flags);
+}
+#endif
+
+
+#if INTCAP_USE_INT2 == YES
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_INT2
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(INT2_vect)
+#endif
+{
+	uint8_t flags = INTCAP_INT2<<1;
+	MCUCSR ^= (1<<ISC2); // catch the opposite edge next
+	if(!(MCUCSR & (1<<ISC2))) {
+		flags |= 1; // now waits for falling, so this one rose
+	}
+	GIFR = (1<<INTF2); // changing ISC2 can raise the flag
+	intCapStore(flags);
+}
+#endif
+/*-----------------------------------------------------*/
+
+
+
+/******************* EXAMPLE CODE *******************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/int/intr/intCapture.h"
+#include "mega16/ext/lcd16x2/lcd.h"
+
+// NEC IR remote on INT0 (TSOP output, active low). All times
+// in 0.5us ticks
+#define NEC_LEADER_MIN 	(8000*2)	// 9ms mark
+#define NEC_ONE_MIN		(1100*2)	// 1.69ms space means 1, 0.56ms means 0
+
+uint32_t necCode;
+uint8_t necBits = 34; // idle till a leader comes
+
+int main() {
+	struct intCapEdge edge;
+	uint16_t lastFall = 0;
+	uint16_t lastRise = 0;
+
+	LCDInit(LS_NONE);
+	LCDClear();
+	intCapInit();
+
+	while(1) {
+		while(intCapRead(&edge)) {
+			if(edge.level) {
+				// rising, end of a mark
+				if((uint16_t)(edge.stamp - lastFall) > NEC_LEADER_MIN) {
+					necBits = 0;
+					necCode = 0;
+				}
+				lastRise = edge.stamp;
+			}
+			else {
+				// falling, end of a space. Long space => 1
+				if(necBits < 33) {
+					necCode >>= 1;
+					if((uint16_t)(edge.stamp - lastRise) > NEC_ONE_MIN) {
+						necCode |= 0x80000000UL;
+					}
+					necBits++;
+				}
+				if(necBits == 33) { // leader space + 32 bits
+					LCDWriteLIntXY(0,0,(necCode>>16) & 0xFF,3);
+					necBits++;
+				}
+				lastFall = edge.stamp;
+			}
+		}
+		// the rest of the main loop may take its time
+		_delay_ms(20);
+	}
+}
+-----------------------------------------------------*/
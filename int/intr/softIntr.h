@@ -14,6 +14,10 @@ NOTE:
 	the programmer has to explicitly define corresponding 
 	software interrupt vecotr i.e. softIntVecX(). Otherwise
 	the library WILL NOT COMPILE
+
+	Only one trigger can be pending at a time and an INT pin
+	is lost to it. For queued calls with arguments and
+	priorities, without a pin, see "dpc.h".
 --------------------------------------------*/
 
 
@@ -0,0 +1,297 @@
+/******************** DESCRIPTION ********************
+Internal part of isrDispatch.h. A driver that wants a share of
+a vector defines ISR_CLAIM_<vector> and includes this file. The
+first free slot of that vector is marked as used and SHARED_ISR
+is set up to open the handler function of that slot.
+
+Do not include this file directly from application code except
+to claim a vector for an own handler (see isrDispatch.h).
+----------------------------------------------------*/
+
+#undef SHARED_ISR
+
+
+#ifdef ISR_CLAIM_INT0
+	#undef ISR_CLAIM_INT0
+	#if !defined(ISR_INT0_0)
+		#define ISR_INT0_0
+		#define SHARED_ISR ISR_SLOT(isr_INT0_0)
+	#elif !defined(ISR_INT0_1)
+		#define ISR_INT0_1
+		#define SHARED_ISR ISR_SLOT(isr_INT0_1)
+	#elif !defined(ISR_INT0_2)
+		#define ISR_INT0_2
+		#define SHARED_ISR ISR_SLOT(isr_INT0_2)
+	#elif !defined(ISR_INT0_3)
+		#define ISR_INT0_3
+		#define SHARED_ISR ISR_SLOT(isr_INT0_3)
+	#else
+		#error MORE THAN 4 HANDLERS ON INT0_vect
+	#endif
+#endif
+
+#ifdef ISR_CLAIM_INT1
+	#undef ISR_CLAIM_INT1
+	#if !defined(ISR_INT1_0)
+		#define ISR_INT1_0
+		#define SHARED_ISR ISR_SLOT(isr_INT1_0)
+	#elif !defined(ISR_INT1_1)
+		#define ISR_INT1_1
+		#define SHARED_ISR ISR_SLOT(isr_INT1_1)
+	#elif !defined(ISR_INT1_2)
+		#define ISR_INT1_2
+		#define SHARED_ISR ISR_SLOT(isr_INT1_2)
+	#elif !defined(ISR_INT1_3)
+		#define ISR_INT1_3
+		#define SHARED_ISR ISR_SLOT(isr_INT1_3)
+	#else
+		#error MORE THAN 4 HANDLERS ON INT1_vect
+	#endif
+#endif
+
+#ifdef ISR_CLAIM_INT2
+	#undef ISR_CLAIM_INT2
+	#if !defined(ISR_INT2_0)
+		#define ISR_INT2_0
+		#define SHARED_ISR ISR_SLOT(isr_INT2_0)
+	#elif !defined(ISR_INT2_1)
+		#define ISR_INT2_1
+		#define SHARED_ISR ISR_SLOT(isr_INT2_1)
+	#elif !defined(ISR_INT2_2)
+		#define ISR_INT2_2
+		#define SHARED_ISR ISR_SLOT(isr_INT2_2)
+	#elif !defined(ISR_INT2_3)
+		#define ISR_INT2_3
+		#define SHARED_ISR ISR_SLOT(isr_INT2_3)
+	#else
+		#error MORE THAN 4 HANDLERS ON INT2_vect
+	#endif
+#endif
+
+#ifdef ISR_CLAIM_TIMER2_COMP
+	#undef ISR_CLAIM_TIMER2_COMP
+	#if !defined(ISR_TIMER2_COMP_0)
+		#define ISR_TIMER2_COMP_0
+		#define SHARED_ISR ISR_SLOT(isr_TIMER2_COMP_0)
+	#elif !defined(ISR_TIMER2_COMP_1)
+		#define ISR_TIMER2_COMP_1
+		#define SHARED_ISR ISR_SLOT(isr_TIMER2_COMP_1)
+	#elif !defined(ISR_TIMER2_COMP_2)
+		#define ISR_TIMER2_COMP_2
+		#define SHARED_ISR ISR_SLOT(isr_TIMER2_COMP_2)
+	#elif !defined(ISR_TIMER2_COMP_3)
+		#define ISR_TIMER2_COMP_3
+		#define SHARED_ISR ISR_SLOT(isr_TIMER2_COMP_3)
+	#else
+		#error MORE THAN 4 HANDLERS ON TIMER2_COMP_vect
+	#endif
+#endif
+
+#ifdef ISR_CLAIM_TIMER2_OVF
+	#undef ISR_CLAIM_TIMER2_OVF
+	#if !defined(ISR_TIMER2_OVF_0)
+		#define ISR_TIMER2_OVF_0
+		#define SHARED_ISR ISR_SLOT(isr_TIMER2_OVF_0)
+	#elif !defined(ISR_TIMER2_OVF_1)
+		#define ISR_TIMER2_OVF_1
+		#define SHARED_ISR ISR_SLOT(isr_TIMER2_OVF_1)
+	#elif !defined(ISR_TIMER2_OVF_2)
+		#define ISR_TIMER2_OVF_2
+		#define SHARED_ISR ISR_SLOT(isr_TIMER2_OVF_2)
+	#elif !defined(ISR_TIMER2_OVF_3)
+		#define ISR_TIMER2_OVF_3
+		#define SHARED_ISR ISR_SLOT(isr_TIMER2_OVF_3)
+	#else
+		#error MORE THAN 4 HANDLERS ON TIMER2_OVF_vect
+	#endif
+#endif
+
+#ifdef ISR_CLAIM_TIMER1_CAPT
+	#undef ISR_CLAIM_TIMER1_CAPT
+	#if !defined(ISR_TIMER1_CAPT_0)
+		#define ISR_TIMER1_CAPT_0
+		#define SHARED_ISR ISR_SLOT(isr_TIMER1_CAPT_0)
+	#elif !defined(ISR_TIMER1_CAPT_1)
+		#define ISR_TIMER1_CAPT_1
+		#define SHARED_ISR ISR_SLOT(isr_TIMER1_CAPT_1)
+	#elif !defined(ISR_TIMER1_CAPT_2)
+		#define ISR_TIMER1_CAPT_2
+		#define SHARED_ISR ISR_SLOT(isr_TIMER1_CAPT_2)
+	#elif !defined(ISR_TIMER1_CAPT_3)
+		#define ISR_TIMER1_CAPT_3
+		#define SHARED_ISR ISR_SLOT(isr_TIMER1_CAPT_3)
+	#else
+		#error MORE THAN 4 HANDLERS ON TIMER1_CAPT_vect
+	#endif
+#endif
+
+#ifdef ISR_CLAIM_TIMER1_COMPA
+	#undef ISR_CLAIM_TIMER1_COMPA
+	#if !defined(ISR_TIMER1_COMPA_0)
+		#define ISR_TIMER1_COMPA_0
+		#define SHARED_ISR ISR_SLOT(isr_TIMER1_COMPA_0)
+	#elif !defined(ISR_TIMER1_COMPA_1)
+		#define ISR_TIMER1_COMPA_1
+		#define SHARED_ISR ISR_SLOT(isr_TIMER1_COMPA_1)
+	#elif !defined(ISR_TIMER1_COMPA_2)
+		#define ISR_TIMER1_COMPA_2
+		#define SHARED_ISR ISR_SLOT(isr_TIMER1_COMPA_2)
+	#elif !defined(ISR_TIMER1_COMPA_3)
+		#define ISR_TIMER1_COMPA_3
+		#define SHARED_ISR ISR_SLOT(isr_TIMER1_COMPA_3)
+	#else
+		#error MORE THAN 4 HANDLERS ON TIMER1_COMPA_vect
+	#endif
+#endif
+
+#ifdef ISR_CLAIM_TIMER1_COMPB
+	#undef ISR_CLAIM_TIMER1_COMPB
+	#if !defined(ISR_TIMER1_COMPB_0)
+		#define ISR_TIMER1_COMPB_0
+		#define SHARED_ISR ISR_SLOT(isr_TIMER1_COMPB_0)
+	#elif !defined(ISR_TIMER1_COMPB_1)
+		#define ISR_TIMER1_COMPB_1
+		#define SHARED_ISR ISR_SLOT(isr_TIMER1_COMPB_1)
+	#elif !defined(ISR_TIMER1_COMPB_2)
+		#define ISR_TIMER1_COMPB_2
+		#define SHARED_ISR ISR_SLOT(isr_TIMER1_COMPB_2)
+	#elif !defined(ISR_TIMER1_COMPB_3)
+		#define ISR_TIMER1_COMPB_3
+		#define SHARED_ISR ISR_SLOT(isr_TIMER1_COMPB_3)
+	#else
+		#error MORE THAN 4 HANDLERS ON TIMER1_COMPB_vect
+	#endif
+#endif
+
+#ifdef ISR_CLAIM_TIMER1_OVF
+	#undef ISR_CLAIM_TIMER1_OVF
+	#if !defined(ISR_TIMER1_OVF_0)
+		#define ISR_TIMER1_OVF_0
+		#define SHARED_ISR ISR_SLOT(isr_TIMER1_OVF_0)
+	#elif !defined(ISR_TIMER1_OVF_1)
+		#define ISR_TIMER1_OVF_1
+		#define SHARED_ISR ISR_SLOT(isr_TIMER1_OVF_1)
+	#elif !defined(ISR_TIMER1_OVF_2)
+		#define ISR_TIMER1_OVF_2
+		#define SHARED_ISR ISR_SLOT(isr_TIMER1_OVF_2)
+	#elif !defined(ISR_TIMER1_OVF_3)
+		#define ISR_TIMER1_OVF_3
+		#define SHARED_ISR ISR_SLOT(isr_TIMER1_OVF_3)
+	#else
+		#error MORE THAN 4 HANDLERS ON TIMER1_OVF_vect
+	#endif
+#endif
+
+#ifdef ISR_CLAIM_TIMER0_OVF
+	#undef ISR_CLAIM_TIMER0_OVF
+	#if !defined(ISR_TIMER0_OVF_0)
+		#define ISR_TIMER0_OVF_0
+		#define SHARED_ISR ISR_SLOT(isr_TIMER0_OVF_0)
+	#elif !defined(ISR_TIMER0_OVF_1)
+		#define ISR_TIMER0_OVF_1
+		#define SHARED_ISR ISR_SLOT(isr_TIMER0_OVF_1)
+	#elif !defined(ISR_TIMER0_OVF_2)
+		#define ISR_TIMER0_OVF_2
+		#define SHARED_ISR ISR_SLOT(isr_TIMER0_OVF_2)
+	#elif !defined(ISR_TIMER0_OVF_3)
+		#define ISR_TIMER0_OVF_3
+		#define SHARED_ISR ISR_SLOT(isr_TIMER0_OVF_3)
+	#else
+		#error MORE THAN 4 HANDLERS ON TIMER0_OVF_vect
+	#endif
+#endif
+
+#ifdef ISR_CLAIM_USART_RXC
+	#undef ISR_CLAIM_USART_RXC
+	#if !defined(ISR_USART_RXC_0)
+		#define ISR_USART_RXC_0
+		#define SHARED_ISR ISR_SLOT(isr_USART_RXC_0)
+	#elif !defined(ISR_USART_RXC_1)
+		#define ISR_USART_RXC_1
+		#define SHARED_ISR ISR_SLOT(isr_USART_RXC_1)
+	#elif !defined(ISR_USART_RXC_2)
+		#define ISR_USART_RXC_2
+		#define SHARED_ISR ISR_SLOT(isr_USART_RXC_2)
+	#elif !defined(ISR_USART_RXC_3)
+		#define ISR_USART_RXC_3
+		#define SHARED_ISR ISR_SLOT(isr_USART_RXC_3)
+	#else
+		#error MORE THAN 4 HANDLERS ON USART_RXC_vect
+	#endif
+#endif
+
+#ifdef ISR_CLAIM_USART_UDRE
+	#undef ISR_CLAIM_USART_UDRE
+	#if !defined(ISR_USART_UDRE_0)
+		#define ISR_USART_UDRE_0
+		#define SHARED_ISR ISR_SLOT(isr_USART_UDRE_0)
+	#elif !defined(ISR_USART_UDRE_1)
+		#define ISR_USART_UDRE_1
+		#define SHARED_ISR ISR_SLOT(isr_USART_UDRE_1)
+	#elif !defined(ISR_USART_UDRE_2)
+		#define ISR_USART_UDRE_2
+		#define SHARED_ISR ISR_SLOT(isr_USART_UDRE_2)
+	#elif !defined(ISR_USART_UDRE_3)
+		#define ISR_USART_UDRE_3
+		#define SHARED_ISR ISR_SLOT(isr_USART_UDRE_3)
+	#else
+		#error MORE THAN 4 HANDLERS ON USART_UDRE_vect
+	#endif
+#endif
+
+#ifdef ISR_CLAIM_ADC
+	#undef ISR_CLAIM_ADC
+	#if !defined(ISR_ADC_0)
+		#define ISR_ADC_0
+		#define SHARED_ISR ISR_SLOT(isr_ADC_0)
+	#elif !defined(ISR_ADC_1)
+		#define ISR_ADC_1
+		#define SHARED_ISR ISR_SLOT(isr_ADC_1)
+	#elif !defined(ISR_ADC_2)
+		#define ISR_ADC_2
+		#define SHARED_ISR ISR_SLOT(isr_ADC_2)
+	#elif !defined(ISR_ADC_3)
+		#define ISR_ADC_3
+		#define SHARED_ISR ISR_SLOT(isr_ADC_3)
+	#else
+		#error MORE THAN 4 HANDLERS ON ADC_vect
+	#endif
+#endif
+
+#ifdef ISR_CLAIM_TWI
+	#undef ISR_CLAIM_TWI
+	#if !defined(ISR_TWI_0)
+		#define ISR_TWI_0
+		#define SHARED_ISR ISR_SLOT(isr_TWI_0)
+	#elif !defined(ISR_TWI_1)
+		#define ISR_TWI_1
+		#define SHARED_ISR ISR_SLOT(isr_TWI_1)
+	#elif !defined(ISR_TWI_2)
+		#define ISR_TWI_2
+		#define SHARED_ISR ISR_SLOT(isr_TWI_2)
+	#elif !defined(ISR_TWI_3)
+		#define ISR_TWI_3
+		#define SHARED_ISR ISR_SLOT(isr_TWI_3)
+	#else
+		#error MORE THAN 4 HANDLERS ON TWI_vect
+	#endif
+#endif
+
+#ifdef ISR_CLAIM_TIMER0_COMP
+	#undef ISR_CLAIM_TIMER0_COMP
+	#if !defined(ISR_TIMER0_COMP_0)
+		#define ISR_TIMER0_COMP_0
+		#define SHARED_ISR ISR_SLOT(isr_TIMER0_COMP_0)
+	#elif !defined(ISR_TIMER0_COMP_1)
+		#define ISR_TIMER0_COMP_1
+		#define SHARED_ISR ISR_SLOT(isr_TIMER0_COMP_1)
+	#elif !defined(ISR_TIMER0_COMP_2)
+		#define ISR_TIMER0_COMP_2
+		#define SHARED_ISR ISR_SLOT(isr_TIMER0_COMP_2)
+	#elif !defined(ISR_TIMER0_COMP_3)
+		#define ISR_TIMER0_COMP_3
+		#define SHARED_ISR ISR_SLOT(isr_TIMER0_COMP_3)
+	#else
+		#error MORE THAN 4 HANDLERS ON TIMER0_COMP_vect
+	#endif
+#endif
@@ -0,0 +1,81 @@
+/******************** DESCRIPTION ********************
+Every driver in this library brings its own ISR. timer0.h and
+T0FreqMeterExtClk.h both want TIMER0_OVF_vect, T2timeKeeper.h,
+timer2.h and timeKeeper.h fight for the Timer2 vectors and so
+on. Two drivers on the same vector do not link.
+
+This library lets several drivers share a vector. Every driver
+hands its ISR body over as a "static inline" handler and one ISR
+per vector is put out at the end, which calls the handlers one
+after another. All of this is resolved at compile time, no
+function pointers are involved. With a single handler the fused
+ISR is the same code as the driver's own ISR.
+
+USAGE:
+	1. #include "mega16/int/isr/isrDispatch.h" 	=> before any driver
+	2. #include the drivers
+	3. #include "mega16/int/isr/isrFuse.h" 		=> after all the drivers
+
+	Without isrDispatch.h the drivers put out their own ISR as before.
+
+CLAIMING A VECTOR FOR OWN CODE:
+	#define ISR_CLAIM_TIMER2_COMP
+	#include "mega16/int/isr/isrClaim.h"
+	SHARED_ISR {
+		// runs inside ISR(TIMER2_COMP_vect) along with the drivers
+	}
+
+VECTORS:
+	INT0, INT1, INT2, TIMER2_COMP, TIMER2_OVF, TIMER1_CAPT,
+	TIMER1_COMPA, TIMER1_COMPB, TIMER1_OVF, TIMER0_OVF, USART_RXC,
+	USART_UDRE, ADC, TWI, TIMER0_COMP. Upto 4 handlers each.
+
+NOTE:
+	Sharing a vector does not share the hardware behind it. Two
+	drivers that both set up OCR2 for different rates still do not
+	work together. The handlers must not assume they are alone.
+----------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#define ISR_DISPATCH 1
+
+// opens the handler function of a claimed slot
+#define ISR_SLOT(name) \
+	static inline void name(void) __attribute__((always_inline)); \
+	static inline void name(void)
+/*------------------------------------------------------*/
+
+
+
+/*********************** EXAMPLE CODE ***********************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/int/isr/isrDispatch.h"
+#include "mega16/int/timer0/T0FreqMeterExtClk.h"
+#include "mega16/int/timer2/T2timeKeeper.h"
+
+// own 1ms job on the same vector as the time keeper
+#define ISR_CLAIM_TIMER2_COMP
+#include "mega16/int/isr/isrClaim.h"
+SHARED_ISR {
+	PORTA ^= (1<<PA7);
+}
+
+#include "mega16/int/isr/isrFuse.h"
+#include "mega16/ext/lcd16x2/lcd.h"
+
+int main() {
+	DDRA |= (1<<PA7);
+	LCDInit(LS_NONE);
+	LCDClear();
+	initT2timeKeeper();
+
+	while(1) {
+		LCDWriteLIntXY(0,0,getFreqCountT0Pin(),6);
+		LCDWriteIntXY(0,1,time.s,2);
+	}
+}
+-----------------------------------------------------------*/
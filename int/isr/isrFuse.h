@@ -0,0 +1,239 @@
+/******************** DESCRIPTION ********************
+Part of isrDispatch.h. Include this file once, after all the
+drivers. For every vector that was claimed it puts out one ISR
+that calls the claimed handlers in the order the drivers were
+included. The handlers are "static inline" and get folded into
+the ISR, so there is no function pointer and no call overhead.
+When only one handler is claimed the ISR is exactly that handler.
+----------------------------------------------------*/
+
+
+#ifndef ISR_DISPATCH
+	#error INCLUDE isrDispatch.h BEFORE THE DRIVERS
+#endif
+
+
+#ifdef ISR_INT0_0
+ISR(INT0_vect) {
+	isr_INT0_0();
+	#ifdef ISR_INT0_1
+		isr_INT0_1();
+	#endif
+	#ifdef ISR_INT0_2
+		isr_INT0_2();
+	#endif
+	#ifdef ISR_INT0_3
+		isr_INT0_3();
+	#endif
+}
+#endif
+
+#ifdef ISR_INT1_0
+ISR(INT1_vect) {
+	isr_INT1_0();
+	#ifdef ISR_INT1_1
+		isr_INT1_1();
+	#endif
+	#ifdef ISR_INT1_2
+		isr_INT1_2();
+	#endif
+	#ifdef ISR_INT1_3
+		isr_INT1_3();
+	#endif
+}
+#endif
+
+#ifdef ISR_INT2_0
+ISR(INT2_vect) {
+	isr_INT2_0();
+	#ifdef ISR_INT2_1
+		isr_INT2_1();
+	#endif
+	#ifdef ISR_INT2_2
+		isr_INT2_2();
+	#endif
+	#ifdef ISR_INT2_3
+		isr_INT2_3();
+	#endif
+}
+#endif
+
+#ifdef ISR_TIMER2_COMP_0
+ISR(TIMER2_COMP_vect) {
+	isr_TIMER2_COMP_0();
+	#ifdef ISR_TIMER2_COMP_1
+		isr_TIMER2_COMP_1();
+	#endif
+	#ifdef ISR_TIMER2_COMP_2
+		isr_TIMER2_COMP_2();
+	#endif
+	#ifdef ISR_TIMER2_COMP_3
+		isr_TIMER2_COMP_3();
+	#endif
+}
+#endif
+
+#ifdef ISR_TIMER2_OVF_0
+ISR(TIMER2_OVF_vect) {
+	isr_TIMER2_OVF_0();
+	#ifdef ISR_TIMER2_OVF_1
+		isr_TIMER2_OVF_1();
+	#endif
+	#ifdef ISR_TIMER2_OVF_2
+		isr_TIMER2_OVF_2();
+	#endif
+	#ifdef ISR_TIMER2_OVF_3
+		isr_TIMER2_OVF_3();
+	#endif
+}
+#endif
+
+#ifdef ISR_TIMER1_CAPT_0
+ISR(TIMER1_CAPT_vect) {
+	isr_TIMER1_CAPT_0();
+	#ifdef ISR_TIMER1_CAPT_1
+		isr_TIMER1_CAPT_1();
+	#endif
+	#ifdef ISR_TIMER1_CAPT_2
+		isr_TIMER1_CAPT_2();
+	#endif
+	#ifdef ISR_TIMER1_CAPT_3
+		isr_TIMER1_CAPT_3();
+	#endif
+}
+#endif
+
+#ifdef ISR_TIMER1_COMPA_0
+ISR(TIMER1_COMPA_vect) {
+	isr_TIMER1_COMPA_0();
+	#ifdef ISR_TIMER1_COMPA_1
+		isr_TIMER1_COMPA_1();
+	#endif
+	#ifdef ISR_TIMER1_COMPA_2
+		isr_TIMER1_COMPA_2();
+	#endif
+	#ifdef ISR_TIMER1_COMPA_3
+		isr_TIMER1_COMPA_3();
+	#endif
+}
+#endif
+
+#ifdef ISR_TIMER1_COMPB_0
+ISR(TIMER1_COMPB_vect) {
+	isr_TIMER1_COMPB_0();
+	#ifdef ISR_TIMER1_COMPB_1
+		isr_TIMER1_COMPB_1();
+	#endif
+	#ifdef ISR_TIMER1_COMPB_2
+		isr_TIMER1_COMPB_2();
+	#endif
+	#ifdef ISR_TIMER1_COMPB_3
+		isr_TIMER1_COMPB_3();
+	#endif
+}
+#endif
+
+#ifdef ISR_TIMER1_OVF_0
+ISR(TIMER1_OVF_vect) {
+	isr_TIMER1_OVF_0();
+	#ifdef ISR_TIMER1_OVF_1
+		isr_TIMER1_OVF_1();
+	#endif
+	#ifdef ISR_TIMER1_OVF_2
+		isr_TIMER1_OVF_2();
+	#endif
+	#ifdef ISR_TIMER1_OVF_3
+		isr_TIMER1_OVF_3();
+	#endif
+}
+#endif
+
+#ifdef ISR_TIMER0_OVF_0
+ISR(TIMER0_OVF_vect) {
+	isr_TIMER0_OVF_0();
+	#ifdef ISR_TIMER0_OVF_1
+		isr_TIMER0_OVF_1();
+	#endif
+	#ifdef ISR_TIMER0_OVF_2
+		isr_TIMER0_OVF_2();
+	#endif
+	#ifdef ISR_TIMER0_OVF_3
+		isr_TIMER0_OVF_3();
+	#endif
+}
+#endif
+
+#ifdef ISR_USART_RXC_0
+ISR(USART_RXC_vect) {
+	isr_USART_RXC_0();
+	#ifdef ISR_USART_RXC_1
+		isr_USART_RXC_1();
+	#endif
+	#ifdef ISR_USART_RXC_2
+		isr_USART_RXC_2();
+	#endif
+	#ifdef ISR_USART_RXC_3
+		isr_USART_RXC_3();
+	#endif
+}
+#endif
+
+#ifdef ISR_USART_UDRE_0
+ISR(USART_UDRE_vect) {
+	isr_USART_UDRE_0();
+	#ifdef ISR_USART_UDRE_1
+		isr_USART_UDRE_1();
+	#endif
+	#ifdef ISR_USART_UDRE_2
+		isr_USART_UDRE_2();
+	#endif
+	#ifdef ISR_USART_UDRE_3
+		isr_USART_UDRE_3();
+	#endif
+}
+#endif
+
+#ifdef ISR_ADC_0
+ISR(ADC_vect) {
+	isr_ADC_0();
+	#ifdef ISR_ADC_1
+		isr_ADC_1();
+	#endif
+	#ifdef ISR_ADC_2
+		isr_ADC_2();
+	#endif
+	#ifdef ISR_ADC_3
+		isr_ADC_3();
+	#endif
+}
+#endif
+
+#ifdef ISR_TWI_0
+ISR(TWI_vect) {
+	isr_TWI_0();
+	#ifdef ISR_TWI_1
+		isr_TWI_1();
+	#endif
+	#ifdef ISR_TWI_2
+		isr_TWI_2();
+	#endif
+	#ifdef ISR_TWI_3
+		isr_TWI_3();
+	#endif
+}
+#endif
+
+#ifdef ISR_TIMER0_COMP_0
+ISR(TIMER0_COMP_vect) {
+	isr_TIMER0_COMP_0();
+	#ifdef ISR_TIMER0_COMP_1
+		isr_TIMER0_COMP_1();
+	#endif
+	#ifdef ISR_TIMER0_COMP_2
+		isr_TIMER0_COMP_2();
+	#endif
+	#ifdef ISR_TIMER0_COMP_3
+		isr_TIMER0_COMP_3();
+	#endif
+}
+#endif
@@ -0,0 +1,227 @@
+/******************** DESCRIPTION ********************
+Measures how long ISRs run and how late they start. An ISR
+marked with ISR_PROF_ENTER(id) at the top and ISR_PROF_EXIT(id)
+at the bottom gets a time stamp from Timer1 (free running at
+2 Mhz) at both places. For every id the library keeps
+	count	=> number of runs
+	min		=> shortest run, in CPU cycles
+	max		=> longest run, in CPU cycles
+	total	=> sum of all runs, in CPU cycles (average = total/count)
+	latency	=> worst delay from the interrupt event to the ISR,
+			   for the ISRs that can tell (see below)
+
+isrProfReport(sink) sends one line per id to a sink of
+io/format.h, e.g. USink of usart.h:
+	id count min max avg latency
+
+With ISR_PROFILE as NO (default) all the macros expand to
+nothing, so the marked drivers compile exactly as before.
+
+ALREADY MARKED:
+	ISR_PROF_ADC 			=> adc.h free running ISR
+	ISR_PROF_TWI 			=> slave.h
+	ISR_PROF_T2_COMP 		=> T2timeKeeper.h, with latency
+	ISR_PROF_TIMEKEEPER 	=> io/timeKeeper.h
+	ISR_PROF_USER and above are free for own ISRs.
+
+LATENCY:
+	The start of an ISR is only known when the hardware keeps a
+	record of the event. A timer in CTC mode does: TCNT counts
+	up from the compare match, so TCNT times the prescaler at
+	the top of the ISR is the delay in cycles.
+		ISR_PROF_LATENCY(ISR_PROF_T2_COMP, TCNT2 * 64);
+	The latency is only as fine as the prescaler of that timer:
+	T2timeKeeper.h in ONE_MS mode (prescaler 64) reports 0, 64,
+	128 ..., where 0 means below 64 cycles. TEN_US mode
+	(prescaler 1) is exact.
+
+USER FUNCTIONS:
+	1. isrProfInit(); 		=> starts Timer1, clears the numbers
+	2. isrProfReset(); 		=> clears the numbers
+	3. isrProfReport(sink); => sends the numbers to sink, e.g. USink
+
+NOTE:
+	isrProfile.h does not include usart.h, the drivers it marks
+	would else all pull in the USART ISRs. The file that calls
+	isrProfReport(USink) includes usart.h and calls USARTInit().
+	The resolution is 8 cycles (one Timer1 tick). The register
+	push/pop of the ISR around the marks is not counted.
+	Timer1 must stay free running (T1Servo.h, logicTrace.h,
+	intCapture.h and pt.h are fine, PWM/CTC users are not).
+	A run longer than 4ms (32768 cycles) is not measured right.
+----------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#undef YES
+#undef NO
+#define YES 1
+#define NO 2
+
+#define ISR_PROF_ADC 0
+#define ISR_PROF_TWI 1
+#define ISR_PROF_T2_COMP 2
+#define ISR_PROF_TIMEKEEPER 3
+#define ISR_PROF_USER 4
+/*------------------------------------------------------*/
+
+
+
+/******************* USER CONFIGURABLE *******************/
+#define ISR_PROFILE NO		// YES turns the marks on
+#define ISR_PROF_SLOTS 8	// ids 0 .. ISR_PROF_SLOTS-1
+/*-------------------------------------------------------*/
+
+
+
+#if ISR_PROFILE == YES
+/********************* DEPENDENCY *********************/
+#ifndef T1_PRESCALER_NONE
+	#include "../timer1/timer1.h"
+#endif
+
+#ifndef FMT_HEX
+	#include "../../io/format.h"
+#endif
+
+#define ISR_PROF_CYCLES_PER_TICK T1_CYCLES_PER_TICK
+/*----------------------------------------------------*/
+
+
+
+/*********************** GLOBAL ***********************/
+struct isrProfSlot {
+	uint16_t enter;		// TCNT1 at ISR_PROF_ENTER
+	uint16_t count;
+	uint16_t min;
+	uint16_t max;
+	uint32_t total;
+	uint16_t latency;
+};
+
+struct isrProf {
+	struct isrProfSlot slot[ISR_PROF_SLOTS];
+} isrProf;
+/*----------------------------------------------------*/
+
+
+
+/*********************** MACROS ***********************/
+#define ISR_PROF_ENTER(id) (isrProf.slot[id].enter = TCNT1)
+#define ISR_PROF_EXIT(id) isrProfExit(&isrProf.slot[id])
+#define ISR_PROF_LATENCY(id, cycles) isrProfLatency(&isrProf.slot[id], (cycles))
+/*----------------------------------------------------*/
+
+
+
+/*********************** INTERNALS ***********************/
+static inline void isrProfExit(struct isrProfSlot *s) __attribute__((always_inline));
+static inline void isrProfExit(struct isrProfSlot *s) {
+	uint16_t cycles = (uint16_t)(TCNT1 - s->enter) * ISR_PROF_CYCLES_PER_TICK;
+	s->count++;
+	s->total += cycles;
+	if(cycles < s->min) {
+		s->min = cycles;
+	}
+	if(cycles > s->max) {
+		s->max = cycles;
+	}
+}
+
+
+static inline void isrProfLatency(struct isrProfSlot *s, uint16_t cycles) __attribute__((always_inline));
+static inline void isrProfLatency(struct isrProfSlot *s, uint16_t cycles) {
+	if(cycles > s->latency) {
+		s->latency = cycles;
+	}
+}
+
+/*-------------------------------------------------------*/
+
+
+
+/******************* USER FUNCTIONS *******************/
+void isrProfReset() {
+	uint8_t i;
+	cli();
+	for(i=0; i<ISR_PROF_SLOTS; i++) {
+		isrProf.slot[i].count = 0;
+		isrProf.slot[i].min = 0xFFFF;
+		isrProf.slot[i].max = 0;
+		isrProf.slot[i].total = 0;
+		isrProf.slot[i].latency = 0;
+	}
+	sei();
+}
+
+
+void isrProfInit() {
+	cli();
+	T1freeRunStart();
+	sei();
+	isrProfReset();
+}
+
+
+// one line per id that ran at least once
+void isrProfReport(fmtSink sink) {
+	struct isrProfSlot s;
+	uint8_t i;
+	for(i=0; i<ISR_PROF_SLOTS; i++) {
+		cli();
+		s = isrProf.slot[i]; // consistent copy
+		sei();
+		if(!s.count) {
+			continue;
+		}
+		fmtPrint_P(sink, PSTR("%u %u %u %u %lu %u\r\n"), i, s.count, s.min, s.max, s.total / s.count, s.latency);
+	}
+}
+/*-----------------------------------------------------*/
+
+#else
+/*********************** MACROS ***********************/
+#define ISR_PROF_ENTER(id)
+#define ISR_PROF_EXIT(id)
+#define ISR_PROF_LATENCY(id, cycles)
+
+#define isrProfInit()
+#define isrProfReset()
+#define isrProfReport(sink)
+/*----------------------------------------------------*/
+#endif
+
+
+
+/******************* EXAMPLE CODE *******************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/int/isr/isrProfile.h"	// ISR_PROFILE is YES
+#include "mega16/int/usart/usart.h"
+#include "mega16/int/adc/adc.h"
+#include "mega16/int/timer2/T2timeKeeper.h"
+
+#define PROF_INT0 ISR_PROF_USER
+
+// own ISR, marked the same way
+ISR(INT0_vect) {
+	ISR_PROF_ENTER(PROF_INT0);
+	PORTA ^= (1<<PA7);
+	ISR_PROF_EXIT(PROF_INT0);
+}
+
+int main() {
+	USARTInit(9600);
+	isrProfInit();
+	initADC(ADC_AVCC);
+	initT2timeKeeper();
+
+	while(1) {
+		_delay_ms(1000);
+		isrProfReport(USink); // "0 9412 296 312 301 0" => ADC ISR takes ~300 cycles
+		isrProfReset();
+	}
+}
+-----------------------------------------------------*/
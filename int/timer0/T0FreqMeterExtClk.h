@@ -7,11 +7,10 @@ cycles coming in on T0 pin in exactly one second time.
 
 NOTE:
 	The function blocks program execution for 1 Second
+	Overflows are counted by the TIMER0_OVF ISR of timer0.h
 
 --------------------------------------------------------*/
 
-volatile uint16_t T0overflow;
-
 /*********************** DEPENDENCY **********************/
 #ifndef T0_OPMODE_NORMAL
 	#include "timer0.h"
@@ -35,12 +34,6 @@ uint32_t getFreqCountT0Pin() {
 
 
 
-ISR(TIMER0_OVF_vect) {
-	T0overflow++;
-}
-
-
-
 /*********************** EXAMPLE CODE ***********************
 #include <avr/io.h>
 #include <util/delay.h>
@@ -29,7 +29,7 @@ low evel control of timer0
 
 
 /*************************** GLOBAL ***************************/
-uint16_t T0overflow;
+volatile uint16_t T0overflow;
 /*------------------------------------------------------------*/
 
 /****************** LOW LEVEL USER FUNCTIONS ******************/
@@ -157,7 +157,14 @@ void T0ocMode(uint8_t oc0Mode) {
 
 
 /****************************** ISR ******************************/
-ISR(TIMER0_OVF_vect) {
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_TIMER0_OVF
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(TIMER0_OVF_vect)
+#endif
+{
 	T0overflow++;
 }
 /*---------------------------------------------------------------*/
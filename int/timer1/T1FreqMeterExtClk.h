@@ -27,7 +27,14 @@ uint32_t getFreqCountT1Pin() {
 
 
 
-ISR(TIMER1_OVF_vect) {
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_TIMER1_OVF
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(TIMER1_OVF_vect)
+#endif
+{
 	T1overflow++;
 }
 
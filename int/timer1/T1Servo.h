@@ -0,0 +1,279 @@
+/*********************** DESCRIPTION ***********************
+This library drives up to 16 hobby servos from Timer1 on any
+GPIO pins. Timer1 free runs at F_CPU/8 (0.5us per tick @ 16Mhz)
+and the compare match interrupt walks through the servos one
+after another.
+
+The 20ms servo frame is cut into 8 slots of 2.5ms. At the
+start of a slot the servo pin is made high and OCR1A is moved
+forward by the pulse width. At that compare match the pin is
+made low and OCR1A is moved forward by the rest of the slot.
+So 8 servos ride on OCR1A. If more than 8 servos are used then
+servo 8..15 ride on OCR1B in the same way.
+
+Every servo has a target and a speed. Once every frame (at the
+start of its own slot) the pulse width is moved towards the
+target by "speed". So slow sweeps run entirely inside the ISR
+and main loop does not have to do anything.
+
+USER FUNCTIONS:
+	1. servoInit(); 				=> starts Timer1 and the compare interrupts
+	2. servoAttach(0, A3); 			=> servo 0 is connected to PA3
+	3. servoDetach(0); 				=> pin goes low and servo 0 stops getting pulses
+	4. servoWrite(0, 1500); 		=> target pulse width of servo 0 in us
+	5. servoSpeed(0, 10); 			=> servo 0 moves 10us per frame (20ms). 0 means jump
+	6. servoIsMoving(0); 			=> non zero as long as servo 0 is ramping
+
+NOTE:
+	"gpio.h" is a must. Before using any functions of this
+	library the programmer will have to call "initGPIO()".
+	Timer1 is used up by this library. It can not be used by
+	T1FastPWM.h or T1FreqMeter.h at the same time.
+	The 0.5us resolution holds for 16Mhz clock.
+-----------------------------------------------------------*/
+
+
+
+
+/*********************** DEPENDENCY ***********************/
+#ifndef GPIO
+	#include "../../io/gpio.h"
+#endif
+
+#ifndef T1_PRESCALER_NONE
+	#include "timer1.h"
+#endif
+/*--------------------------------------------------------*/
+
+
+
+
+/******************* USER CONFIGURABLE *******************/
+#define SERVO_COUNT 8		// 1..16. Servo 0..7 on OCR1A, 8..15 on OCR1B
+#define SERVO_MIN_US 500	// shortest pulse allowed
+#define SERVO_MAX_US 2400	// longest pulse allowed (must stay below slot length 2500us)
+#define SERVO_START_US 1500	// pulse width right after servoAttach()
+/*-------------------------------------------------------*/
+
+
+
+
+/*********************** INTERNAL ***********************/
+#define SERVO_FRAME_US 20000
+#define SERVO_SLOT_TICKS T1_US_TICKS(SERVO_FRAME_US/8)
+
+#if SERVO_COUNT > 8
+	#define SERVO_CHANNELS 16
+#else
+	#define SERVO_CHANNELS 8
+#endif
+
+#if SERVO_COUNT > 16
+	#error SERVO_COUNT CAN NOT BE MORE THAN 16
+#endif
+/*-----------------------------------------------------*/
+
+
+
+
+/************************* GLOBAL *************************/
+struct servoChannel {
+	volatile uint8_t *port;		// 0 means not attached
+	uint8_t mask;
+	volatile uint16_t pulse;	// present pulse width in timer ticks
+	volatile uint16_t target;	// target pulse width in timer ticks
+	volatile uint16_t speed;	// ticks per frame, 0 => jump to target
+};
+
+struct servoBank {
+	volatile uint8_t index;	// which slot of the frame is running
+	volatile uint8_t isHigh;	// pulse of that slot is in progress
+};
+
+struct servo {
+	struct servoChannel ch[SERVO_CHANNELS];
+	struct servoBank bankA;
+	struct servoBank bankB;
+} servo;
+/*--------------------------------------------------------*/
+
+
+
+
+/******************* USER FUNCTIONS *******************/
+void servoInit() {
+	uint8_t i;
+	for(i=0; i<SERVO_CHANNELS; i++) {
+		servo.ch[i].port = 0;
+		servo.ch[i].pulse = T1_US_TICKS(SERVO_START_US);
+		servo.ch[i].target = T1_US_TICKS(SERVO_START_US);
+		servo.ch[i].speed = 0;
+	}
+	servo.bankA.index = 0;
+	servo.bankA.isHigh = 0;
+	servo.bankB.index = 0;
+	servo.bankB.isHigh = 0;
+
+	cli();
+	T1ocAMode(T1_OC_NORNAL); // pins are driven by the ISR, not by OC1A/OC1B
+	T1ocBMode(T1_OC_NORNAL);
+	T1freeRunStart();
+	OCR1A = TCNT1 + 100;
+	clearOC1AInterruptFlag();
+	enableOC1AInterrupt();
+	#if SERVO_COUNT > 8
+		OCR1B = TCNT1 + 200;
+		clearOC1BInterruptFlag();
+		enableOC1BInterrupt();
+	#endif
+	sei();
+}
+
+
+void servoAttach(uint8_t n, uint8_t pos) {
+	outLow(pos); // make it output
+	cli();
+	servo.ch[n].mask = (1<<getOriginalPos(pos));
+	servo.ch[n].port = getOriginalGPIO(pos, PORTx);
+	sei();
+}
+
+
+void servoDetach(uint8_t n) {
+	cli();
+	if(servo.ch[n].port) {
+		*servo.ch[n].port &= ~servo.ch[n].mask;
+	}
+	servo.ch[n].port = 0;
+	sei();
+}
+
+
+// pulse width in us
+void servoWrite(uint8_t n, uint16_t us) {
+	if(us < SERVO_MIN_US) {
+		us = SERVO_MIN_US;
+	}
+	if(us > SERVO_MAX_US) {
+		us = SERVO_MAX_US;
+	}
+	cli(); // 16 bit value is shared with the ISR
+	servo.ch[n].target = T1_US_TICKS(us);
+	sei();
+}
+
+
+// us per frame (20ms). 0 means jump to target in next frame
+void servoSpeed(uint8_t n, uint16_t usPerFrame) {
+	cli();
+	servo.ch[n].speed = T1_US_TICKS(usPerFrame);
+	sei();
+}
+
+
+uint8_t servoIsMoving(uint8_t n) {
+	uint8_t moving;
+	cli();
+	moving = (servo.ch[n].pulse != servo.ch[n].target);
+	sei();
+	return moving;
+}
+/*-----------------------------------------------------*/
+
+
+
+
+/*********************** INTERNALS ***********************/
+// runs one edge of a slot and returns how far the compare
+// register has to be moved for the next edge
+static inline uint16_t servoSlotEdge(struct servoBank *bank, struct servoChannel *first) {
+	struct servoChannel *s = first + bank->index;
+	uint16_t pulse = s->pulse;
+
+	if(bank->isHigh) {
+		// end of pulse
+		if(s->port) {
+			*s->port &= ~s->mask;
+		}
+		bank->isHigh = 0;
+		bank->index = (bank->index + 1) & 7;
+		return SERVO_SLOT_TICKS - pulse;
+	}
+
+	// start of slot. move one step towards the target
+	uint16_t target = s->target;
+	uint16_t speed = s->speed;
+	if(speed == 0) {
+		pulse = target;
+	}
+	else if(pulse < target) {
+		pulse = (target - pulse > speed) ? pulse + speed : target;
+	}
+	else if(pulse > target) {
+		pulse = (pulse - target > speed) ? pulse - speed : target;
+	}
+	s->pulse = pulse;
+
+	if(s->port) {
+		*s->port |= s->mask;
+	}
+	bank->isHigh = 1;
+	return pulse;
+}
+/*-------------------------------------------------------*/
+
+
+
+
+/*************************** ISR ***************************/
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_TIMER1_COMPA
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(TIMER1_COMPA_vect)
+#endif
+{
+	OCR1A += servoSlotEdge(&servo.bankA, &servo.ch[0]);
+}
+
+#if SERVO_COUNT > 8
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_TIMER1_COMPB
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(TIMER1_COMPB_vect)
+#endif
+{
+	OCR1B += servoSlotEdge(&servo.bankB, &servo.ch[8]);
+}
+#endif
+/*---------------------------------------------------------*/
+
+
+
+
+/************************ EXAMPLE CODE ************************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/int/timer1/T1Servo.h"
+
+int main() {
+	initGPIO();
+	servoInit();
+	servoAttach(0, A0);
+	servoAttach(1, A1);
+	servoSpeed(1, 5); // 5us every 20ms => 1000us sweep in 4 Sec
+
+	while(1) {
+		servoWrite(0, 1000);
+		servoWrite(1, 1000);
+		_delay_ms(5000);
+		servoWrite(0, 2000);
+		servoWrite(1, 2000);
+		_delay_ms(5000);
+	}
+}
+-------------------------------------------------------------*/
@@ -0,0 +1,448 @@
+/*********************** DESCRIPTION ***********************
+This library generates step/dir pulse trains for stepper motor
+drivers (A4988, DRV8825 and alike) with Timer1 in CTC mode.
+Nothing is bit banged with _delay_us() so main loop keeps on
+running while the motors move.
+
+Timer1 runs at 2 Mhz (16Mhz/8). OCR1A holds the time to the next
+step. Every compare match the ISR puts out one step and works out
+the next step interval from the previous one (linear speed ramp):
+
+	c(n) = c(n-1) - 2*c(n-1) / (4n + 1)
+
+Only integer add, shift and one division are needed per ramp step.
+At cruise speed there is no division at all. This is the same
+scheme as in Atmel application note AVR446. The division is done
+in 16 bit whenever the numbers fit, which is always the case near
+top speed, so 20+ kSteps/s (50us per step) are sustained.
+
+Several axes move in lock-step. The axis with the most steps is
+the master and sets the timing, the others are stepped along a
+straight line with Bresenham error accumulators.
+
+USER FUNCTIONS:
+	1. stepperInit(); 					=> sets up Timer1
+	2. stepperAttach(0, B0, B1); 		=> axis 0 STEP on PB0, DIR on PB1
+	3. stepperMove(steps, acc, dec, v); => relative move of all axes. steps[] is
+										   one signed count per axis. acc & dec in
+										   steps/s^2 (upto 65535) and v (top speed)
+										   in steps/s
+	4. stepperBusy(); 					=> non zero while a move is running
+	5. stepperStop(); 					=> ramps down and stops
+	6. stepperHalt(); 					=> stops right now (no ramp)
+	7. stepper.axis[0].position 		=> absolute position of axis 0 in steps
+
+NOTE:
+	"gpio.h" is a must. Before using any functions of this
+	library the programmer will have to call "initGPIO()".
+	Timer1 is used up by this library (not together with T1Servo.h).
+	The STEP pulse is as long as the ISR body, which is more than
+	the 2us the common driver chips ask for.
+-----------------------------------------------------------*/
+
+
+
+
+/*********************** DEPENDENCY ***********************/
+#ifndef GPIO
+	#include "../../io/gpio.h"
+#endif
+
+#ifndef T1_PRESCALER_NONE
+	#include "timer1.h"
+#endif
+/*--------------------------------------------------------*/
+
+
+
+
+/******************* USER CONFIGURABLE *******************/
+#define STEPPER_AXES 3	// number of axes moved in lock-step
+/*-------------------------------------------------------*/
+
+
+
+
+/*********************** INTERNAL ***********************/
+#define STEPPER_STOP 0
+#define STEPPER_ACCEL 1
+#define STEPPER_RUN 2
+#define STEPPER_DECEL 3
+
+#define STEPPER_T_FREQ (F_CPU/8)	// timer clock, 2 Mhz @ 16Mhz
+// c0 = 0.676 * T_FREQ * sqrt(2/acc) = (0.956 * T_FREQ) / sqrt(acc)
+// sqrt(acc) is taken as sqrt(100*acc)/10 to keep one more digit
+#define STEPPER_C0_K ((STEPPER_T_FREQ/1000UL) * 9560UL)
+/*-----------------------------------------------------*/
+
+
+
+
+/************************* GLOBAL *************************/
+struct stepperAxis {
+	volatile uint8_t *stepPort;
+	uint8_t stepMask;
+	volatile uint8_t *dirPort;
+	uint8_t dirMask;
+	volatile int32_t position;	// absolute position in steps
+	uint32_t steps;		// number of steps of this axis in current move
+	uint32_t error;		// bresenham accumulator
+	int8_t dir;			// +1 or -1
+};
+
+struct stepper {
+	struct stepperAxis axis[STEPPER_AXES];
+	volatile uint8_t state;
+	uint16_t stepDelay;		// ticks to the next step
+	uint16_t minDelay;		// ticks per step at top speed
+	uint16_t lastAccelDelay;
+	uint32_t rest;			// carried remainder of the ramp division
+	uint32_t totalSteps;	// steps of the master axis
+	uint32_t stepCount;
+	uint32_t decelStart;	// step at which slowing down starts
+	int32_t decelVal;		// negative length of the down ramp
+	int32_t accelCount;		// n of the ramp formula
+} stepper;
+/*--------------------------------------------------------*/
+
+
+
+
+/*********************** INTERNALS ***********************/
+uint32_t stepperSqrt(uint32_t x) {
+	uint32_t root = 0;
+	uint32_t bit = 1UL<<30;
+	while(bit > x) {
+		bit >>= 2;
+	}
+	while(bit) {
+		if(x >= root + bit) {
+			x -= root + bit;
+			root = (root>>1) + bit;
+		}
+		else {
+			root >>= 1;
+		}
+		bit >>= 2;
+	}
+	return root;
+}
+
+
+// one step of the ramp: delay +/- (2*delay + rest)/(4n + 1)
+// n < 0 while slowing down, then the delay grows. n == 0 is the
+// last step of the ramp, the delay stays as it is
+static inline uint16_t stepperRamp(uint16_t delay, int32_t n) {
+	uint32_t num = 2UL*delay + stepper.rest;
+	uint32_t den = (n < 0) ? (uint32_t)(-4*n - 1) : (uint32_t)(4*n + 1);
+	uint16_t q;
+
+	if(n == 0) {
+		return delay;
+	}
+
+	if(num <= 0xFFFF && den <= 0xFFFF) { // fast 16 bit path
+		q = (uint16_t)num / (uint16_t)den;
+		stepper.rest = (uint16_t)num % (uint16_t)den;
+	}
+	else {
+		q = num / den;
+		stepper.rest = num % den;
+	}
+	return (n < 0) ? delay + q : delay - q;
+}
+
+
+static inline void stepperPulseHigh() {
+	uint8_t i;
+	struct stepperAxis *a;
+	for(i=0; i<STEPPER_AXES; i++) {
+		a = &stepper.axis[i];
+		a->error += a->steps;
+		if(a->error >= stepper.totalSteps) {
+			a->error -= stepper.totalSteps;
+			if(a->stepPort) {
+				*a->stepPort |= a->stepMask;
+			}
+			a->position += a->dir;
+		}
+	}
+}
+
+
+static inline void stepperPulseLow() {
+	uint8_t i;
+	for(i=0; i<STEPPER_AXES; i++) {
+		if(stepper.axis[i].stepPort) {
+			*stepper.axis[i].stepPort &= ~stepper.axis[i].stepMask;
+		}
+	}
+}
+/*-------------------------------------------------------*/
+
+
+
+
+/******************* USER FUNCTIONS *******************/
+void stepperInit() {
+	uint8_t i;
+	for(i=0; i<STEPPER_AXES; i++) {
+		stepper.axis[i].stepPort = 0;
+		stepper.axis[i].dirPort = 0;
+		stepper.axis[i].position = 0;
+		stepper.axis[i].steps = 0;
+	}
+	stepper.state = STEPPER_STOP;
+
+	T1ClockSelect(T1_PRESCALER_NONE); // stays stopped till a move comes
+	TCCR1A &= ~(3);
+	TCCR1B &= ~(24);
+	T1ocAMode(T1_OC_NORNAL);
+	T1operationMode(4); // CTC, TOP = OCR1A
+}
+
+
+void stepperAttach(uint8_t n, uint8_t stepPos, uint8_t dirPos) {
+	outLow(stepPos);
+	outLow(dirPos);
+	stepper.axis[n].stepPort = getOriginalGPIO(stepPos, PORTx);
+	stepper.axis[n].stepMask = (1<<getOriginalPos(stepPos));
+	stepper.axis[n].dirPort = getOriginalGPIO(dirPos, PORTx);
+	stepper.axis[n].dirMask = (1<<getOriginalPos(dirPos));
+}
+
+
+#define stepperBusy() (stepper.state != STEPPER_STOP)
+
+
+// returns 0 if a move is still running, else 1
+uint8_t stepperMove(const int32_t steps[STEPPER_AXES], uint16_t accel, uint16_t decel, uint16_t speed) {
+	uint8_t i;
+	uint32_t total = 0;
+	uint32_t maxSLim, accelLim;
+	uint32_t c0, ratio;
+
+	if(stepperBusy()) {
+		return 0;
+	}
+
+	// directions and the master axis
+	for(i=0; i<STEPPER_AXES; i++) {
+		struct stepperAxis *a = &stepper.axis[i];
+		if(steps[i] < 0) {
+			a->dir = -1;
+			a->steps = -steps[i];
+			if(a->dirPort) {
+				*a->dirPort &= ~a->dirMask;
+			}
+		}
+		else {
+			a->dir = 1;
+			a->steps = steps[i];
+			if(a->dirPort) {
+				*a->dirPort |= a->dirMask;
+			}
+		}
+		if(a->steps > total) {
+			total = a->steps;
+		}
+	}
+	if(total == 0 || speed == 0 || accel == 0 || decel == 0) {
+		return 1;
+	}
+	for(i=0; i<STEPPER_AXES; i++) {
+		stepper.axis[i].error = total>>1; // centre the line
+	}
+
+	stepper.totalSteps = total;
+	stepper.stepCount = 0;
+	stepper.rest = 0;
+	stepper.accelCount = 0;
+
+	if(total == 1) {
+		stepper.accelCount = -1;
+		stepper.state = STEPPER_DECEL;
+		stepper.stepDelay = 1000;
+	}
+	else {
+		c0 = STEPPER_T_FREQ / speed;
+		stepper.minDelay = (c0 > 0xFFFF) ? 0xFFFF : c0;
+
+		// first step interval
+		c0 = STEPPER_C0_K / stepperSqrt(accel*100UL);
+		stepper.stepDelay = (c0 > 0xFFFF) ? 0xFFFF : c0;
+
+		// steps needed to reach top speed
+		maxSLim = ((uint32_t)speed*speed) / (2UL*accel);
+		if(maxSLim == 0) {
+			maxSLim = 1;
+		}
+		// step where acceleration must end to stop in time
+		// total * decel/(accel+decel), with the ratio in 16.16 fixed point
+		ratio = ((uint32_t)decel<<16) / ((uint32_t)accel + decel);
+		accelLim = (total>>16)*ratio + (((total & 0xFFFF)*ratio)>>16);
+		if(accelLim == 0) {
+			accelLim = 1;
+		}
+
+		if(accelLim <= maxSLim) {
+			stepper.decelVal = (int32_t)accelLim - (int32_t)total;
+		}
+		else {
+			stepper.decelVal = -(int32_t)((((uint32_t)speed*speed)>>1)/decel);
+		}
+		if(stepper.decelVal == 0) {
+			stepper.decelVal = -1;
+		}
+		stepper.decelStart = total + stepper.decelVal;
+
+		if(stepper.stepDelay <= stepper.minDelay) {
+			stepper.stepDelay = stepper.minDelay;
+			stepper.lastAccelDelay = stepper.minDelay; // DECEL starts from here
+			stepper.state = STEPPER_RUN;
+		}
+		else {
+			stepper.state = STEPPER_ACCEL;
+		}
+	}
+
+	// kick off
+	cli();
+	OCR1A = 10;
+	TCNT1 = 0;
+	clearOC1AInterruptFlag();
+	enableOC1AInterrupt();
+	T1ClockSelect(T1_PRESCALER_8);
+	sei();
+	return 1;
+}
+
+
+// ramps down from the present speed and stops
+void stepperStop() {
+	cli();
+	if(stepper.state == STEPPER_ACCEL) {
+		stepper.decelVal = -stepper.accelCount;
+		stepper.decelStart = stepper.stepCount;
+	}
+	else if(stepper.state == STEPPER_RUN) {
+		stepper.decelVal = -(int32_t)(stepper.totalSteps - stepper.decelStart);
+		if(stepper.decelVal == 0) {
+			stepper.decelVal = -1;
+		}
+		stepper.decelStart = stepper.stepCount;
+	}
+	sei();
+}
+
+
+// stops at once. Motor may loose steps at high speed
+void stepperHalt() {
+	cli();
+	T1ClockSelect(T1_PRESCALER_NONE);
+	disableOC1AInterrupt();
+	stepperPulseLow();
+	stepper.state = STEPPER_STOP;
+	sei();
+}
+/*-----------------------------------------------------*/
+
+
+
+
+/*************************** ISR ***************************/
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_TIMER1_COMPA
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(TIMER1_COMPA_vect)
+#endif
+{
+	uint16_t newDelay = stepper.stepDelay;
+	OCR1A = stepper.stepDelay;
+
+	switch(stepper.state) {
+		case STEPPER_STOP:
+			T1ClockSelect(T1_PRESCALER_NONE);
+			disableOC1AInterrupt();
+			return;
+
+		case STEPPER_ACCEL:
+			stepperPulseHigh();
+			stepper.stepCount++;
+			stepper.accelCount++;
+			newDelay = stepperRamp(stepper.stepDelay, stepper.accelCount);
+			if(stepper.stepCount >= stepper.decelStart) {
+				stepper.accelCount = stepper.decelVal;
+				stepper.state = STEPPER_DECEL;
+			}
+			else if(newDelay <= stepper.minDelay) {
+				stepper.lastAccelDelay = newDelay;
+				newDelay = stepper.minDelay;
+				stepper.rest = 0;
+				stepper.state = STEPPER_RUN;
+			}
+			break;
+
+		case STEPPER_RUN:
+			stepperPulseHigh();
+			stepper.stepCount++;
+			newDelay = stepper.minDelay;
+			if(stepper.stepCount >= stepper.decelStart) {
+				stepper.accelCount = stepper.decelVal;
+				newDelay = stepper.lastAccelDelay;
+				stepper.state = STEPPER_DECEL;
+			}
+			break;
+
+		case STEPPER_DECEL:
+			stepperPulseHigh();
+			stepper.stepCount++;
+			stepper.accelCount++;
+			newDelay = stepperRamp(stepper.stepDelay, stepper.accelCount);
+			if(stepper.accelCount >= 0) {
+				// last step. Timer off before stepperBusy() reads 0, so a
+				// new stepperMove() never meets a compare of this one
+				T1ClockSelect(T1_PRESCALER_NONE);
+				disableOC1AInterrupt();
+				stepper.state = STEPPER_STOP;
+			}
+			break;
+	}
+	stepper.stepDelay = newDelay;
+	stepperPulseLow();
+}
+/*---------------------------------------------------------*/
+
+
+
+
+/************************ EXAMPLE CODE ************************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/int/timer1/T1Stepper.h"
+
+int32_t move[STEPPER_AXES] = { 3200, -1600, 800 };
+
+int main() {
+	initGPIO();
+	stepperInit();
+	stepperAttach(0, B0, B1);
+	stepperAttach(1, B2, B3);
+	stepperAttach(2, B4, B5);
+
+	while(1) {
+		// 20000 steps/s top speed, 40000 steps/s^2 both ways
+		stepperMove(move, 40000, 40000, 20000);
+		while(stepperBusy()) {
+			// main loop is free here
+		}
+		move[0] = -move[0];
+		move[1] = -move[1];
+		move[2] = -move[2];
+		_delay_ms(500);
+	}
+}
+-------------------------------------------------------------*/
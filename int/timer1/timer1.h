@@ -165,6 +165,21 @@ void T1ocBMode(uint8_t ocMode) {
 
 // diable timer1
 #define T1disable() (T1ClockSelect(T1_PRESCALER_NONE)) // stops the timmer from runnign
+
+
+// free running time base. Timer1 in normal mode at F_CPU/8 (2 Mhz @ 16Mhz)
+// TCNT1 then works as a 16 bit time stamp which rolls over every 65536
+// ticks (32.768 ms @ 16Mhz, 524 ms @ 1Mhz)
+#define T1_TICKS_PER_S (F_CPU/8)
+#define T1_CYCLES_PER_TICK 8
+// us => ticks at any F_CPU, no overflow on the way (upto 35 minutes @ 16Mhz)
+#define T1_US_TICKS(us) ((uint32_t)(us) / 1000UL * (F_CPU/8000UL) + (uint32_t)(us) % 1000UL * (F_CPU/8000UL) / 1000UL)
+
+void T1freeRunStart() {
+	TCCR1A &= ~(3);		// WGM11:10 = 0
+	TCCR1B &= ~(24);	// WGM13:12 = 0 => normal mode
+	T1ClockSelect(T1_PRESCALER_8);
+}
 /*--------------------------------------------------------------*/
 
 
@@ -57,6 +57,10 @@ FUTURE:
 #ifndef T2_PRESCALER_NONE
 	#include "timer2.h"
 #endif
+
+#ifndef ISR_PROF_SLOTS
+	#include "../isr/isrProfile.h"
+#endif
 /*--------------------------------------------------------*/
 
 
@@ -71,6 +75,16 @@ FUTURE:
 #define D_CALLBACK NO
 /*--------------------------------------------------------*/
 
+// CPU cycles per Timer2 clock, for the ISR latency mark. It is also
+// the step the latency is measured in (64 cycles in ONE_MS mode)
+#if TIME_BASE == TEN_US
+	#define T2_TK_PRESCALER 1
+#elif TIME_BASE == HUNDRED_US
+	#define T2_TK_PRESCALER 8
+#else
+	#define T2_TK_PRESCALER 64
+#endif
+
 /******************** GLOBAL VARIABLES ********************/
 struct timekeeper{
 volatile uint16_t us;
@@ -203,7 +217,16 @@ void disableTimeKeeper(){
 
 
 #if TIME_BASE == TEN_US
-ISR (TIMER2_COMP_vect){
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_TIMER2_COMP
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(TIMER2_COMP_vect)
+#endif
+{
+	ISR_PROF_LATENCY(ISR_PROF_T2_COMP, TCNT2 * T2_TK_PRESCALER);
+	ISR_PROF_ENTER(ISR_PROF_T2_COMP);
 	time.us += 10;
 	#if US_CALLBACK == YES
 		timekeeper_us_callback();
@@ -270,6 +293,7 @@ ISR (TIMER2_COMP_vect){
 			}
 		}
 	}
+	ISR_PROF_EXIT(ISR_PROF_T2_COMP);
 }
 #endif
 
@@ -277,7 +301,16 @@ ISR (TIMER2_COMP_vect){
 
 
 #if TIME_BASE == HUNDRED_US
-ISR (TIMER2_COMP_vect){
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_TIMER2_COMP
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(TIMER2_COMP_vect)
+#endif
+{
+	ISR_PROF_LATENCY(ISR_PROF_T2_COMP, TCNT2 * T2_TK_PRESCALER);
+	ISR_PROF_ENTER(ISR_PROF_T2_COMP);
 	time.us += 100;
 	#if US_CALLBACK == YES
 		timekeeper_us_callback();
@@ -344,13 +377,23 @@ ISR (TIMER2_COMP_vect){
 			}
 		}
 	}
+	ISR_PROF_EXIT(ISR_PROF_T2_COMP);
 }
 #endif
 
 
 
 #if TIME_BASE == ONE_MS
-ISR (TIMER2_COMP_vect){
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_TIMER2_COMP
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(TIMER2_COMP_vect)
+#endif
+{
+	ISR_PROF_LATENCY(ISR_PROF_T2_COMP, TCNT2 * T2_TK_PRESCALER);
+	ISR_PROF_ENTER(ISR_PROF_T2_COMP);
 	time.ms++;
 	if(timeLoop.msCounter0){
 		timeLoop.msCounter0--;
@@ -410,6 +453,7 @@ ISR (TIMER2_COMP_vect){
 			}
 		}
 	}
+	ISR_PROF_EXIT(ISR_PROF_T2_COMP);
 }
 #endif
 
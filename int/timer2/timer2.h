@@ -29,7 +29,7 @@ low evel control of timer2
 
 
 /*************************** GLOBAL ***************************/
-uint16_t T2overflow;
+volatile uint16_t T2overflow;
 /*------------------------------------------------------------*/
 
 
@@ -162,7 +162,14 @@ void T2ocMode(uint8_t ocMode) {
 
 
 /****************************** ISR ******************************/
-ISR(TIMER2_OVF_vect) {
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_TIMER2_OVF
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(TIMER2_OVF_vect)
+#endif
+{
 	T2overflow++;
 }
 /*---------------------------------------------------------------*/
@@ -0,0 +1,277 @@
+/******************** DESCRIPTION ********************
+Reliable transport over framer.h (Go-Back-N). Every frame sent
+with arqSend() arrives once, in order, or the sender keeps
+trying. It works like this:
+
+	DATA frame	=> type ARQ_DATA, SEQ DATA[len]
+	ACK frame	=> type ARQ_ACK, NEXT
+
+SEQ counts 0 ... 255 and round again. The receiver takes only
+the frame it waits for (SEQ == NEXT) and answers every DATA frame
+with the SEQ it wants next, so one ACK confirms all the frames
+before it and a lost ACK is made good by the next one.
+
+The sender keeps up to ARQ_WINDOW frames out at the same time,
+each in its own static buffer, and sends a new one at once
+without waiting for the ACK of the one before. On a slow RF link
+with a long turn around the line stays busy instead of idle
+between a frame and its ACK (stop-and-wait is ARQ_WINDOW 1).
+
+When the oldest frame is not confirmed within ARQ_TIMEOUT_MS all
+the frames out are sent again, from the oldest on. The timeout
+runs on timeLoop.msCounter3 of T2timeKeeper.h.
+
+USER FUNCTIONS:
+	1. arqInit(); 					=> after framerInit(), both ends start at SEQ 0
+	2. arqSend(data, len); 			=> 1 if taken, 0 if the window is full
+	3. arqGet(); 					=> like framerGet(). Gives the DATA frames in
+									   order and every frame of other types,
+									   handles the ACKs and the timeout itself
+	4. arqData(f), arqLen(f); 		=> data and length of a DATA frame
+	5. frameRelease(f); 			=> as with framer.h
+	6. arqPending(); 				=> frames sent but not confirmed yet
+	7. arq.resent, arq.timeouts,
+	   arq.dropped 					=> frames sent again, timeouts, DATA frames
+									   not taken (out of order or twice)
+
+NOTE:
+	arq.h has to be included before framer.h, it includes it and
+	adds ARQ_DATA and ARQ_ACK to framerTypes[].
+	initT2timeKeeper() has to be running (TIME_BASE ONE_MS), and
+	nothing else may use timeLoop.msCounter3.
+	arqGet() has to be called often, nothing happens without it.
+	The window is at most 64 frames, SEQ must tell a new frame
+	from an old one sent again.
+	When one end starts over (reset) the other one has to call
+	arqInit() as well, else the SEQ do not match.
+----------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#undef YES
+#undef NO
+#define YES 1
+#define NO 2
+/*------------------------------------------------------*/
+
+
+
+/******************* USER CONFIGURABLE *******************/
+#define ARQ_WINDOW 4			// frames out at the same time. 1, 2, 4 ... 64
+#define ARQ_MAX_LEN 16			// data bytes per frame, upto FRAME_MAX_LEN-1
+#define ARQ_TIMEOUT_MS 250		// send again when not confirmed in this time
+#define ARQ_DATA 'S'			// frame types, not used for anything else
+#define ARQ_ACK 'A'
+/*-------------------------------------------------------*/
+
+
+
+/********************* DEPENDENCY *********************/
+#ifdef FRAME_POOL
+	#error INCLUDE arq.h BEFORE framer.h
+#endif
+#include "framer.h"
+
+#ifndef T2_TK_PRESCALER
+	#include "../timer2/T2timeKeeper.h"
+#endif
+
+#if (ARQ_WINDOW & (ARQ_WINDOW - 1)) || ARQ_WINDOW > 64
+	#error ARQ_WINDOW MUST BE A POWER OF 2 UPTO 64
+#endif
+#if ARQ_MAX_LEN + 1 > FRAME_MAX_LEN
+	#error ARQ_MAX_LEN MUST BE UPTO FRAME_MAX_LEN-1
+#endif
+/*----------------------------------------------------*/
+
+
+
+/*********************** GLOBAL ***********************/
+struct arqSlot {
+	uint8_t len;						// data bytes
+	uint8_t frame[ARQ_MAX_LEN + 1];		// SEQ DATA[len], as sent
+};
+
+struct arq {
+	struct arqSlot slot[ARQ_WINDOW];	// slot of SEQ is SEQ % ARQ_WINDOW
+	uint8_t base;		// oldest SEQ not confirmed
+	uint8_t next;		// SEQ of the next new frame
+	uint8_t expect;		// SEQ the receiver waits for
+	uint16_t resent;
+	uint16_t timeouts;
+	uint16_t dropped;
+} arq;
+/*----------------------------------------------------*/
+
+
+
+/*********************** MACROS ***********************/
+#define arqData(f) ((f)->data + 1)
+#define arqLen(f) ((f)->len - 1)
+#define arqPending() ((uint8_t)(arq.next - arq.base))
+/*----------------------------------------------------*/
+
+
+
+/*********************** INTERNALS ***********************/
+// timeLoop.msCounter3 is 16 bit and counted down in the ISR
+static void arqTimerSet(uint16_t ms) {
+	uint8_t sreg = SREG;
+	cli();
+	timeLoop.msCounter3 = ms;
+	SREG = sreg;
+}
+
+
+static uint8_t arqTimerDone() {
+	uint16_t ms;
+	uint8_t sreg = SREG;
+	cli();
+	ms = timeLoop.msCounter3;
+	SREG = sreg;
+	return ms == 0;
+}
+
+
+static void arqTransmit(uint8_t seq) {
+	struct arqSlot *s = &arq.slot[seq & (ARQ_WINDOW - 1)];
+	framerSend(ARQ_DATA, s->frame, s->len + 1);
+}
+
+
+// the SEQ the receiver wants next, confirms all before it
+static void arqAck() {
+	framerSend(ARQ_ACK, &arq.expect, 1);
+}
+
+
+static void arqAcked(uint8_t next) {
+	uint8_t done = next - arq.base;
+	if(done == 0 || done > arqPending()) {
+		return; // old or broken ACK
+	}
+	arq.base = next;
+	arqTimerSet(arq.base == arq.next ? 0 : ARQ_TIMEOUT_MS);
+}
+
+
+// go back: everything out is sent again, oldest first
+static void arqTimeout() {
+	uint8_t seq;
+	if(arq.base == arq.next || !arqTimerDone()) {
+		return;
+	}
+	arq.timeouts++;
+	for(seq = arq.base; seq != arq.next; seq++) {
+		arqTransmit(seq);
+		arq.resent++;
+	}
+	arqTimerSet(ARQ_TIMEOUT_MS);
+}
+/*-------------------------------------------------------*/
+
+
+
+/******************* USER FUNCTIONS *******************/
+void arqInit() {
+	arq.base = 0;
+	arq.next = 0;
+	arq.expect = 0;
+	arq.resent = 0;
+	arq.timeouts = 0;
+	arq.dropped = 0;
+	arqTimerSet(0);
+}
+
+
+uint8_t arqSend(const void *data, uint8_t len) {
+	struct arqSlot *s;
+	const uint8_t *src = data;
+	uint8_t i;
+
+	if(arqPending() == ARQ_WINDOW) {
+		return 0;
+	}
+	if(len > ARQ_MAX_LEN) {
+		len = ARQ_MAX_LEN;
+	}
+	s = &arq.slot[arq.next & (ARQ_WINDOW - 1)];
+	s->len = len;
+	s->frame[0] = arq.next;
+	for(i=0; i<len; i++) {
+		s->frame[1 + i] = src[i];
+	}
+	if(arq.base == arq.next) {
+		arqTimerSet(ARQ_TIMEOUT_MS);
+	}
+	arqTransmit(arq.next++);
+	return 1;
+}
+
+
+// next DATA frame in order or frame of another type, 0 if none
+struct frame *arqGet() {
+	struct frame *f;
+
+	arqTimeout();
+	while((f = framerGet())) {
+		if(f->type == ARQ_ACK) {
+			if(f->len == 1) {
+				arqAcked(f->data[0]);
+			}
+			frameRelease(f);
+		}
+		else if(f->type == ARQ_DATA) {
+			if(f->len && f->data[0] == arq.expect) {
+				arq.expect++;
+				arqAck();
+				return f;
+			}
+			arq.dropped++;
+			arqAck(); // tells the sender where to go back to
+			frameRelease(f);
+		}
+		else {
+			return f;
+		}
+	}
+	return 0;
+}
+/*-----------------------------------------------------*/
+
+
+
+/******************* EXAMPLE CODE *******************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/int/usart/arq.h"	// includes framer.h and usart.h
+#include "mega16/ext/lcd16x2/lcd.h"
+
+int main() {
+	struct frame *f;
+	uint16_t count = 0;
+
+	LCDInit(LS_NONE);
+	LCDClear();
+	initT2timeKeeper();
+	framerInit();
+	arqInit();
+	USARTInit(2400);
+
+	while(1) {
+		// keep the window full, the counter goes over in order
+		if(arqSend(&count, sizeof(count))) {
+			count++;
+		}
+		while((f = arqGet())) {
+			if(f->type == ARQ_DATA) {
+				LCDWriteIntXY(0, 0, *(uint16_t *)arqData(f), 5);
+			}
+			frameRelease(f);
+		}
+		LCDWriteIntXY(0, 1, arq.resent, 5);
+	}
+}
+-----------------------------------------------------*/
@@ -0,0 +1,263 @@
+/******************** DESCRIPTION ********************
+Finds the baud rate of a device from one sync character. The
+device (or the person at the terminal) sends 0x55, 'U', which
+on the wire is a start bit and 8 data bits that flip every bit:
+
+	line:	1 1 1 | 0 | 1 0 1 0 1 0 1 0 | 1
+			idle  | S | 0 1 2 3 4 5 6 7 | stop
+
+The line is polled and every edge gets a Timer1 stamp (2 Mhz).
+The time from the rising edge at the end of the start bit to the
+rising edge at the start of the stop bit is exactly 8 bits. Both
+are rising edges, so a driver that rises slower than it falls
+(RS-232 and opto couplers do) does not bend the result. Every
+single bit in between must also be close to 1/8 of it, else the
+character was not 0x55 and nothing is changed.
+
+The rate found can be snapped to the nearest standard rate
+(1200 ... 115200) when it is within 3% of it.
+
+USER FUNCTIONS:
+	1. USARTAutoBaud(timeoutMs); 				=> waits for 0x55 on RXD (PD0)
+												   and starts usart.h at its rate
+	2. softUSARTAutoBaud(&usart0, timeoutMs); 	=> same for a softUSART.h object
+												   on its rx pin
+	3. autoBaudMeasure(&PINx, mask, timeoutMs); => the measurement alone, any pin
+	All return the baud rate, 0 if nothing usable came in time.
+
+NOTE:
+	Timer1 runs free (T1freeRunStart()), shared with the other
+	free running users.
+	Interrupts are off from the start bit to the stop bit (one
+	character), so no ISR can delay a stamp. While waiting for
+	the start bit they stay as they were.
+	The 0x55 itself is used up, a receiver on the same pin gets
+	it as garbage: USARTAutoBaud() restarts usart.h (rings
+	empty), softUSARTintr.h should be started after
+	softUSARTAutoBaud().
+	At 115200 a bit is 17 Timer1 ticks and the poll loop is
+	about 2 ticks, the rate is then good to about 1%. Snapping
+	takes care of the rest.
+----------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#undef YES
+#undef NO
+#define YES 1
+#define NO 2
+/*------------------------------------------------------*/
+
+
+
+/******************* USER CONFIGURABLE *******************/
+#define AUTOBAUD_HW YES			// USARTAutoBaud() for usart.h
+#define AUTOBAUD_SOFT NO		// softUSARTAutoBaud() for softUSART.h
+#define AUTOBAUD_SNAP YES		// round to a standard rate within 3%
+#define AUTOBAUD_MIN 1200		// slowest rate looked for
+#define AUTOBAUD_MAX 115200		// fastest rate looked for
+/*-------------------------------------------------------*/
+
+
+
+/********************* DEPENDENCY *********************/
+#ifndef T1_PRESCALER_NONE
+	#include "../timer1/timer1.h"
+#endif
+
+#if AUTOBAUD_HW == YES
+	#ifndef RCV_PKT_LEN
+		#include "usart.h"
+	#endif
+#endif
+
+#if AUTOBAUD_SOFT == YES
+	#ifndef BAUD_DELAY
+		#include "../../softUSART/softUSART.h"
+	#endif
+#endif
+
+#define AB_TICKS_PER_S (F_CPU / 8)	// Timer1 free running, prescaler 8
+#define AB_TICKS_PER_MS (F_CPU / 8000)
+#define AB_EDGE_TICKS (AB_TICKS_PER_S * 3 / 2 / AUTOBAUD_MIN)	// 1.5 bits at the slowest
+#define AB_MIN_SPAN (AB_TICKS_PER_S * 8 * 9 / 10 / AUTOBAUD_MAX)	// 8 bits at the fastest, -10%
+
+#if AB_EDGE_TICKS > 32767
+	#error AUTOBAUD_MIN TOO LOW FOR TIMER1
+#endif
+/*----------------------------------------------------*/
+
+
+
+/*********************** INTERNALS ***********************/
+#if AUTOBAUD_SNAP == YES
+const uint32_t autoBaudRates[] = {
+	1200, 2400, 4800, 9600, 14400, 19200, 28800, 38400, 57600, 76800, 115200
+};
+#endif
+
+
+// waits for the pin to become "want" (mask or 0). The stamp is
+// taken just before the read that saw it, the same for every edge
+static inline uint8_t autoBaudEdge(volatile uint8_t *pin, uint8_t mask, uint8_t want, uint16_t *stamp) {
+	uint16_t t0 = TCNT1;
+	uint16_t now;
+	do {
+		now = TCNT1;
+		if((uint16_t)(now - t0) > AB_EDGE_TICKS) {
+			return 0;
+		}
+	} while((*pin & mask) != want);
+	*stamp = now;
+	return 1;
+}
+/*-------------------------------------------------------*/
+
+
+
+/******************* USER FUNCTIONS *******************/
+uint32_t autoBaudMeasure(volatile uint8_t *pin, uint8_t mask, uint16_t timeoutMs) {
+	uint16_t stamp[9];	// rising, falling ... rising
+	uint16_t span;
+	uint16_t bit;
+	uint16_t tol;
+	uint16_t t0;
+	uint8_t idle = 0;
+	uint8_t sreg;
+	uint8_t ok = 1;
+	uint8_t i;
+	uint32_t baud;
+
+	T1freeRunStart();
+
+	// idle (high) first, then the falling edge of the start bit
+	while(1) {
+		t0 = TCNT1;
+		while((uint16_t)(TCNT1 - t0) < AB_TICKS_PER_MS) {
+			if(*pin & mask) {
+				idle = 1;
+			}
+			else if(idle) {
+				goto start;
+			}
+		}
+		if(!timeoutMs--) {
+			return 0;
+		}
+	}
+
+start:
+	sreg = SREG;
+	cli();
+	for(i=0; i<9 && ok; i++) {
+		ok = autoBaudEdge(pin, mask, i & 1 ? 0 : mask, &stamp[i]);
+	}
+	SREG = sreg;
+	if(!ok) {
+		return 0;
+	}
+
+	span = stamp[8] - stamp[0];
+	if(span < AB_MIN_SPAN) {
+		return 0;
+	}
+	// every bit within 3/8 of the average, else it was not 0x55.
+	// Slow rising edges make the high bits shorter and the low
+	// ones longer, two bits in a row are twice as long
+	bit = span >> 3;
+	tol = (bit >> 2) + (bit >> 3);
+	for(i=0; i<8; i++) {
+		uint16_t d = stamp[i + 1] - stamp[i];
+		if(d < bit - tol || d > bit + tol) {
+			return 0;
+		}
+	}
+
+	baud = (AB_TICKS_PER_S * 8 + span / 2) / span;
+
+	#if AUTOBAUD_SNAP == YES
+		for(i=0; i<sizeof(autoBaudRates)/sizeof(autoBaudRates[0]); i++) {
+			uint32_t r = autoBaudRates[i];
+			if(baud > r - r * 3 / 100 && baud < r + r * 3 / 100) {
+				return r;
+			}
+		}
+	#endif
+	return baud;
+}
+
+
+#if AUTOBAUD_HW == YES
+uint32_t USARTAutoBaud(uint16_t timeoutMs) {
+	uint32_t baud = autoBaudMeasure(&PIND, (1<<PD0), timeoutMs);
+	if(baud) {
+		USARTInit(baud);
+	}
+	return baud;
+}
+#endif
+
+
+#if AUTOBAUD_SOFT == YES
+uint32_t softUSARTAutoBaud(struct softUsart *usart, uint16_t timeoutMs) {
+	volatile uint8_t *pin;
+	uint8_t pos = usart->rx - A0; // 0 => PA0 ... 31 => PD7
+	uint32_t baud;
+
+	if(pos < 8) {
+		pin = &PINA;
+	}
+	else if(pos < 16) {
+		pin = &PINB;
+	}
+	else if(pos < 24) {
+		pin = &PINC;
+	}
+	else {
+		pin = &PIND;
+	}
+	inHigh(usart->rx);
+	baud = autoBaudMeasure(pin, 1 << (pos & 7), timeoutMs);
+	if(baud > 0xFFFF) {
+		return 0; // beyond softUSART.h anyway
+	}
+	if(baud) {
+		softUSARTSetBaud(usart, baud);
+	}
+	return baud;
+}
+#endif
+/*-----------------------------------------------------*/
+
+
+
+/******************* EXAMPLE CODE *******************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/int/usart/autoBaud.h"	// includes usart.h
+#include "mega16/ext/lcd16x2/lcd.h"
+
+int main() {
+	uint32_t baud;
+
+	LCDInit(LS_NONE);
+	LCDClear();
+	LCDWriteStringXY(0, 0, "send U ...");
+
+	// the terminal sends 'U' till we answer
+	while(!(baud = USARTAutoBaud(1000)));
+
+	LCDClear();
+	LCDPrintf("%lu baud", baud);
+	UPrintf("hello at %lu baud\r\n", baud);
+
+	while(1) {
+		uint8_t c;
+		while(URead(&c)) {
+			UWriteData(c);
+		}
+	}
+}
+-----------------------------------------------------*/
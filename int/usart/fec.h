@@ -0,0 +1,291 @@
+/******************** DESCRIPTION ********************
+Forward error correction for serial links. Every data byte goes
+out as two code bytes, one per nibble, in extended Hamming(8,4):
+4 data bits, 3 Hamming parity bits and one parity bit over all.
+Any two code bytes differ in at least 4 bits, so the receiver
+	- corrects one flipped bit per code byte
+	- spots two flipped bits (the byte is passed on anyway, the
+	  CRC of framer.h or of the program throws it out)
+
+Both ways are a table lookup in flash (16 bytes to encode, 256 to
+decode), a few cycles per byte, cheap enough for the RX ISR.
+
+The code bytes are the Hamming words XORed with 0x03. Then no code
+byte is 0x00, not even with one bit flipped, so the 0x00 frame end
+of COBS still works, and the sync word 0xAA 0x55 is not a code
+byte either.
+
+With FEC_INTERLEAVE as YES the code bytes go in blocks of 8 (4 data
+bytes) turned by 90 degree: bit j of sent byte i is bit i of code
+byte j. A burst of noise up to 8 bits long, a whole byte spoilt on
+the wire, then flips only one bit in each code byte and all of it
+is corrected. The last block of a run is filled up with code bytes
+of 0x00, the receiver gets those as extra 0x00 data bytes.
+
+	FEC_INTERLEAVE NO	=> 2 bytes on the wire per data byte
+	FEC_INTERLEAVE YES	=> same, but in blocks of 8
+
+framer.h uses it with FRAMER_FEC as YES: the sync word stays as
+it is, TYPE ... CRCH are coded (with COBS: all but the 0x00). Any
+other link, e.g. softUSART.h or softUSARTintr.h, feeds the bytes
+through the same functions with its own sink.
+
+USER FUNCTIONS:
+	1. fecTxInit(&tx); 					=> before a run of bytes
+	2. fecTxByte(&tx, byte, sink); 		=> codes one byte, the code bytes go to sink(c)
+	3. fecTxEnd(&tx, sink); 			=> fills up the last block (interleave only)
+	4. fecRxInit(&rx); 					=> before a run of code bytes, e.g. at the sync word
+	5. fecRxByte(&rx, code, sink); 		=> takes one code byte from the wire, the
+										   decoded data bytes go to sink(c)
+	6. fec.fixed 						=> bits corrected
+	7. fec.bad 							=> code bytes with 2 bits flipped (not corrected)
+
+NOTE:
+	The line carries twice the bytes, a frame takes twice as long.
+	fec.fixed and fec.bad are 16 bit and counted in the ISR, read
+	them with interrupts off.
+	fecRxByte() is what the RX ISR calls. Without interleave it is
+	a lookup every second byte. With interleave every 8th byte
+	turns the block (about 600 cycles), fine upto 115200 at 16 Mhz.
+	Three or more flipped bits in a code byte can be taken for
+	one and "corrected" to a wrong nibble, the CRC is still needed.
+----------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#undef YES
+#undef NO
+#define YES 1
+#define NO 2
+
+// fecDecodeTable[] flags
+#define FEC_FIXED 0x10	// one bit was flipped and is corrected
+#define FEC_BAD 0x20	// two bits flipped, nibble is a guess
+/*------------------------------------------------------*/
+
+
+
+/******************* USER CONFIGURABLE *******************/
+#define FEC_INTERLEAVE NO		// YES => blocks of 8 code bytes, turned
+/*-------------------------------------------------------*/
+
+
+
+/********************* DEPENDENCY *********************/
+#include <avr/pgmspace.h>
+
+#if FEC_INTERLEAVE == YES
+	#define FEC_BLOCK 8		// code bytes per block
+#else
+	#define FEC_BLOCK 2
+#endif
+/*----------------------------------------------------*/
+
+
+
+/*********************** GLOBAL ***********************/
+typedef void (*fecSink)(uint8_t c);
+
+struct fecTx {
+	uint8_t n;
+	#if FEC_INTERLEAVE == YES
+		uint8_t block[FEC_BLOCK];
+	#endif
+};
+
+struct fecRx {
+	uint8_t n;
+	uint8_t block[FEC_BLOCK];
+};
+
+struct fec {
+	volatile uint16_t fixed;
+	volatile uint16_t bad;
+} fec;
+
+// nibble => code byte
+const uint8_t fecEncodeTable[16] PROGMEM = {
+	0x03, 0xB2, 0xD1, 0x60, 0xE7, 0x56, 0x35, 0x84,
+	0x7B, 0xCA, 0xA9, 0x18, 0x9F, 0x2E, 0x4D, 0xFC
+};
+
+// code byte => nibble | FEC_FIXED | FEC_BAD
+const uint8_t fecDecodeTable[256] PROGMEM = {
+	0x20, 0x10, 0x10, 0x00, 0x17, 0x20, 0x20, 0x10, 0x1B, 0x20, 0x20, 0x10, 0x27, 0x1E, 0x1D, 0x20,
+	0x1B, 0x20, 0x20, 0x10, 0x25, 0x16, 0x15, 0x20, 0x0B, 0x1B, 0x1B, 0x20, 0x1B, 0x26, 0x25, 0x1C,
+	0x13, 0x20, 0x20, 0x10, 0x23, 0x16, 0x1D, 0x20, 0x23, 0x1A, 0x1D, 0x20, 0x1D, 0x26, 0x0D, 0x1D,
+	0x21, 0x16, 0x11, 0x20, 0x16, 0x06, 0x21, 0x16, 0x1B, 0x26, 0x21, 0x18, 0x26, 0x16, 0x1D, 0x26,
+	0x13, 0x20, 0x20, 0x10, 0x23, 0x1E, 0x15, 0x20, 0x23, 0x1E, 0x19, 0x20, 0x1E, 0x0E, 0x25, 0x1E,
+	0x22, 0x12, 0x15, 0x20, 0x15, 0x22, 0x05, 0x15, 0x1B, 0x22, 0x25, 0x18, 0x25, 0x1E, 0x15, 0x25,
+	0x03, 0x13, 0x13, 0x20, 0x13, 0x23, 0x23, 0x14, 0x13, 0x23, 0x23, 0x18, 0x23, 0x1E, 0x1D, 0x24,
+	0x13, 0x22, 0x21, 0x18, 0x23, 0x16, 0x15, 0x24, 0x23, 0x18, 0x18, 0x08, 0x1F, 0x26, 0x25, 0x18,
+	0x17, 0x20, 0x20, 0x10, 0x07, 0x17, 0x17, 0x20, 0x27, 0x1A, 0x19, 0x20, 0x17, 0x27, 0x27, 0x1C,
+	0x21, 0x12, 0x11, 0x20, 0x17, 0x22, 0x21, 0x1C, 0x1B, 0x22, 0x21, 0x1C, 0x27, 0x1C, 0x1C, 0x0C,
+	0x21, 0x1A, 0x11, 0x20, 0x17, 0x24, 0x21, 0x14, 0x1A, 0x0A, 0x21, 0x1A, 0x27, 0x1A, 0x1D, 0x24,
+	0x11, 0x21, 0x01, 0x11, 0x21, 0x16, 0x11, 0x21, 0x21, 0x1A, 0x11, 0x21, 0x1F, 0x26, 0x21, 0x1C,
+	0x22, 0x12, 0x19, 0x20, 0x17, 0x22, 0x24, 0x14, 0x19, 0x22, 0x09, 0x19, 0x27, 0x1E, 0x19, 0x24,
+	0x12, 0x02, 0x21, 0x12, 0x22, 0x12, 0x15, 0x22, 0x22, 0x12, 0x19, 0x22, 0x1F, 0x22, 0x25, 0x1C,
+	0x13, 0x22, 0x21, 0x14, 0x23, 0x14, 0x14, 0x04, 0x23, 0x1A, 0x19, 0x24, 0x1F, 0x24, 0x24, 0x14,
+	0x21, 0x12, 0x11, 0x21, 0x1F, 0x22, 0x21, 0x14, 0x1F, 0x22, 0x21, 0x18, 0x0F, 0x1F, 0x1F, 0x24
+};
+/*----------------------------------------------------*/
+
+
+
+/*********************** INTERNALS ***********************/
+#define fecEncode(nibble) pgm_read_byte(&fecEncodeTable[(nibble) & 0x0F])
+
+
+static inline uint8_t fecDecode(uint8_t code) {
+	uint8_t d = pgm_read_byte(&fecDecodeTable[code]);
+	if(d & FEC_FIXED) {
+		fec.fixed++;
+	}
+	else if(d & FEC_BAD) {
+		fec.bad++;
+	}
+	return d & 0x0F;
+}
+
+
+#if FEC_INTERLEAVE == YES
+// bit j of b[i] <=> bit i of b[j]. Its own inverse
+static void fecTurn(uint8_t *b) {
+	uint8_t t[8] = { 0 };
+	uint8_t i;
+	uint8_t j;
+	uint8_t x;
+	for(j=0; j<8; j++) {
+		x = b[j];
+		for(i=0; i<8; i++) {
+			t[i] >>= 1;
+			if(x & 1) {
+				t[i] |= 0x80;
+			}
+			x >>= 1;
+		}
+	}
+	for(i=0; i<8; i++) {
+		b[i] = t[i];
+	}
+}
+#endif
+/*-------------------------------------------------------*/
+
+
+
+/******************* USER FUNCTIONS *******************/
+void fecTxInit(struct fecTx *s) {
+	s->n = 0;
+}
+
+
+// low nibble first
+void fecTxByte(struct fecTx *s, uint8_t byte, fecSink sink) {
+	#if FEC_INTERLEAVE == YES
+		uint8_t i;
+		s->block[s->n++] = fecEncode(byte);
+		s->block[s->n++] = fecEncode(byte >> 4);
+		if(s->n == FEC_BLOCK) {
+			fecTurn(s->block);
+			for(i=0; i<FEC_BLOCK; i++) {
+				sink(s->block[i]);
+			}
+			s->n = 0;
+		}
+	#else
+		(void)s;
+		sink(fecEncode(byte));
+		sink(fecEncode(byte >> 4));
+	#endif
+}
+
+
+// sends what is left of the last block, filled up with 0x00 bytes
+void fecTxEnd(struct fecTx *s, fecSink sink) {
+	#if FEC_INTERLEAVE == YES
+		while(s->n) {
+			fecTxByte(s, 0, sink);
+		}
+	#else
+		(void)s;
+		(void)sink;
+	#endif
+}
+
+
+void fecRxInit(struct fecRx *s) {
+	s->n = 0;
+}
+
+
+// one code byte from the wire. Called from the RX ISR
+void fecRxByte(struct fecRx *s, uint8_t code, fecSink sink) {
+	uint8_t i;
+	s->block[s->n++] = code;
+	if(s->n < FEC_BLOCK) {
+		return;
+	}
+	s->n = 0;
+	#if FEC_INTERLEAVE == YES
+		fecTurn(s->block);
+	#endif
+	for(i=0; i<FEC_BLOCK; i+=2) {
+		sink(fecDecode(s->block[i]) | (fecDecode(s->block[i + 1]) << 4));
+	}
+}
+/*-----------------------------------------------------*/
+
+
+
+/******************* EXAMPLE CODE *******************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/int/usart/fec.h"
+#include "mega16/softUSART/softUSARTintr.h"	// RX_CALLBACK is YES
+#include "mega16/ext/lcd16x2/lcd.h"
+
+// softUSART link: coded bytes out on usart0, decoded ones shown
+struct softUsart usart0;
+struct fecTx fecOut;
+struct fecRx fecIn;
+volatile uint8_t lastByte;
+
+void usart0Sink(uint8_t c) {
+	softUSARTWrite(&usart0, c);
+}
+
+void decoded(uint8_t c) {
+	lastByte = c;
+}
+
+void softRX_callback() {
+	fecRxByte(&fecIn, softUsartData.receivedByte, decoded);
+}
+
+int main() {
+	uint8_t i = 0;
+
+	initGPIO();
+	usart0.rx = D2;
+	usart0.tx = A1;
+	LCDInit(LS_NONE);
+	LCDClear();
+	fecTxInit(&fecOut);
+	fecRxInit(&fecIn);
+	initSoftUSARTintr(&usart0);
+	sei();
+
+	while(1) {
+		fecTxByte(&fecOut, i++, usart0Sink);
+		fecTxEnd(&fecOut, usart0Sink);
+		LCDWriteIntXY(0, 0, lastByte, 3);
+		cli();
+		LCDWriteIntXY(0, 1, fec.fixed, 5); // noise that did no harm
+		sei();
+		_delay_ms(200);
+	}
+}
+-----------------------------------------------------*/
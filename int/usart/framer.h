@@ -0,0 +1,475 @@
+/******************** DESCRIPTION ********************
+Packet framing on top of usart.h. The packet filter of usart.h
+takes one fixed format with a fixed number of data bytes and no
+check. Here every frame carries its own type and length, and a
+CRC-16 so a frame broken on the way is thrown away:
+
+	SYNC1 SYNC2 | TYPE LEN DATA[LEN] CRCL CRCH
+
+	CRC-16 CCITT (avr-libc _crc_ccitt_update, start 0xFFFF) over
+	TYPE, LEN and DATA, low byte first.
+
+With FRAMER_COBS as YES there is no sync word. TYPE ... CRCH is
+COBS encoded, so it has no 0x00 in it, and a 0x00 closes the
+frame. A receiver finds the start of the next frame at the next
+0x00 whatever happened before, at a cost of one byte per 254.
+
+	COBS(TYPE LEN DATA[LEN] CRCL CRCH) 0x00
+
+With FRAMER_FEC as YES every byte after the sync word (with COBS
+every byte but the 0x00) goes out Hamming coded by fec.h, as two
+bytes. One flipped bit per code byte is corrected on the way in,
+so a noisy line loses far fewer frames. fec.fixed counts the
+corrected bits. Both ends need the same setting.
+
+Every TYPE the program takes is listed in framerTypes[] with its
+largest length. Frames of other types or longer are dropped. Any
+number of types may be in use at the same time.
+
+The USART RX ISR hands every byte to framerRxByte(), which does a
+fixed small amount of work per byte. The data is written straight
+into a frame taken from a pool (FRAME_POOL frames) and the frame
+itself is handed to the main loop, nothing is copied. The main
+loop gives it back with frameRelease() once done with it.
+
+USER FUNCTIONS:
+	1. framerInit(); 					=> before USARTInit()
+	2. framerGet(); 					=> oldest complete frame (struct frame *), 0 if none
+	3. frameRelease(frame); 			=> frame goes back to the pool
+	4. framerSend(type, data, len); 	=> sends one frame (queued, see usart.h)
+	5. framerRxByte(byte); 				=> feeds one received byte. Called
+										   by the USART RX ISR already
+	6. framer.badCrc, framer.badLen,
+	   framer.badType, framer.noFrame	=> frames dropped and why
+
+NOTE:
+	FEC_INTERLEAVE of fec.h works with the sync word only, the
+	turned blocks can hold a 0x00.
+	int/usart/arq.h adds acknowledgements and sending again on
+	top, so frames are not lost.
+	framer.h has to be included before usart.h (it includes it
+	itself), else the RX ISR does not know about the framer.
+	The packet filter of usart.h keeps running on the same bytes.
+	noFrame counts frames dropped because all frames of the pool
+	were still held by the main loop. Release frames soon.
+----------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#undef YES
+#undef NO
+#define YES 1
+#define NO 2
+
+// receive states
+#define FR_HUNT 0	// looking for SYNC1 (0x00 with COBS)
+#define FR_SYNC2 1
+#define FR_TYPE 2
+#define FR_LEN 3
+#define FR_DATA 4
+#define FR_CRCL 5
+#define FR_CRCH 6
+/*------------------------------------------------------*/
+
+
+
+/******************* USER CONFIGURABLE *******************/
+#define FRAMER_COBS NO			// YES => COBS with 0x00 as frame end, NO => sync word
+#define FRAMER_SYNC1 0xAA		// sync word (FRAMER_COBS NO only)
+#define FRAMER_SYNC2 0x55
+#define FRAMER_FEC NO			// YES => TYPE ... CRCH Hamming coded, see fec.h
+#define FRAME_MAX_LEN 32		// data bytes of the longest frame, upto 250
+#define FRAME_POOL 4			// frames in the pool. 2, 4, 8 ... 128
+
+// {type, largest length}. Only these types are received
+const uint8_t framerTypes[][2] = {
+	{ 'T', 8 },				// e.g. telemetry
+	{ 'C', 2 },				// e.g. command
+	{ 'D', FRAME_MAX_LEN },	// e.g. data block
+#ifdef ARQ_WINDOW
+	{ ARQ_DATA, ARQ_MAX_LEN + 1 },	// arq.h
+	{ ARQ_ACK, 1 },
+#endif
+};
+/*-------------------------------------------------------*/
+
+
+
+/********************* DEPENDENCY *********************/
+#ifdef RCV_PKT_LEN
+	#error INCLUDE framer.h BEFORE usart.h
+#endif
+#define USART_RX_HOOK framerRxByte
+void framerRxByte(uint8_t byte);
+#include "usart.h"
+
+#include <util/crc16.h>
+
+#if FRAMER_FEC == YES
+	#ifndef FEC_FIXED
+		#include "fec.h"
+	#endif
+	#if FRAMER_COBS == YES && FEC_INTERLEAVE == YES
+		#error FEC_INTERLEAVE NEEDS FRAMER_COBS NO
+	#endif
+#endif
+
+#if FRAME_MAX_LEN > 250
+	#error FRAME_MAX_LEN MUST BE UPTO 250
+#endif
+/*----------------------------------------------------*/
+
+
+
+/*********************** GLOBAL ***********************/
+struct frame {
+	uint8_t type;
+	uint8_t len;
+	uint8_t data[FRAME_MAX_LEN];
+};
+
+struct frame framePool[FRAME_POOL];
+
+// frame numbers (index in framePool) passed between ISR and main
+RING_TYPE(frameRing, uint8_t, FRAME_POOL)
+
+struct framer {
+	struct frameRing free;	// main loop => ISR
+	struct frameRing ready;	// ISR => main loop
+	uint8_t state;
+	uint8_t cur;			// frame being filled
+	uint8_t hold;			// cur belongs to the ISR
+	uint8_t maxLen;			// of the current type
+	uint8_t index;
+	uint8_t crcLow;
+	uint16_t crc;
+	#if FRAMER_COBS == YES
+		uint8_t cobsLeft;	// data bytes left in the COBS block
+		uint8_t cobsCode;	// code byte of the block
+	#endif
+	#if FRAMER_FEC == YES
+		struct fecRx fecRx;	// code bytes of the current frame
+	#endif
+	volatile uint8_t badCrc;
+	volatile uint8_t badLen;
+	volatile uint8_t badType;
+	volatile uint8_t noFrame;
+} framer;
+/*----------------------------------------------------*/
+
+
+
+/*********************** INTERNALS ***********************/
+// 1 and the largest length if the type is taken, else 0
+static inline uint8_t framerLookup(uint8_t type, uint8_t *maxLen) {
+	uint8_t i;
+	for(i=0; i<sizeof(framerTypes)/sizeof(framerTypes[0]); i++) {
+		if(framerTypes[i][0] == type) {
+			*maxLen = framerTypes[i][1] < FRAME_MAX_LEN ? framerTypes[i][1] : FRAME_MAX_LEN;
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+// one byte of TYPE ... CRCH, after sync or COBS decoding
+static inline void framerField(uint8_t byte) {
+	struct frame *f = &framePool[framer.cur];
+
+	switch(framer.state) {
+		case FR_TYPE:
+			if(!framer.hold) {
+				if(!frameRingPop(&framer.free, &framer.cur)) {
+					framer.noFrame++;
+					framer.state = FR_HUNT;
+					break;
+				}
+				framer.hold = 1;
+				f = &framePool[framer.cur];
+			}
+			if(!framerLookup(byte, &framer.maxLen)) {
+				framer.badType++;
+				framer.state = FR_HUNT;
+				break;
+			}
+			f->type = byte;
+			framer.crc = _crc_ccitt_update(0xFFFF, byte);
+			framer.state = FR_LEN;
+			break;
+
+		case FR_LEN:
+			if(byte > framer.maxLen) {
+				framer.badLen++;
+				framer.state = FR_HUNT;
+				break;
+			}
+			f->len = byte;
+			framer.crc = _crc_ccitt_update(framer.crc, byte);
+			framer.index = 0;
+			framer.state = byte ? FR_DATA : FR_CRCL;
+			break;
+
+		case FR_DATA:
+			f->data[framer.index++] = byte;
+			framer.crc = _crc_ccitt_update(framer.crc, byte);
+			if(framer.index == f->len) {
+				framer.state = FR_CRCL;
+			}
+			break;
+
+		case FR_CRCL:
+			framer.crcLow = byte;
+			framer.state = FR_CRCH;
+			break;
+
+		case FR_CRCH:
+			if(framer.crc == (((uint16_t)byte << 8) | framer.crcLow)) {
+				frameRingPush(&framer.ready, framer.cur); // never full, holds all frames
+				framer.hold = 0;
+			}
+			else {
+				framer.badCrc++;
+			}
+			framer.state = FR_HUNT;
+			break;
+
+		default: // FR_HUNT: rest of a dropped frame
+			break;
+	}
+}
+
+
+#if FRAMER_COBS == YES
+// one COBS coded byte, not 0x00
+static void framerCobsByte(uint8_t byte) {
+	if(framer.state == FR_HUNT) {
+		return;
+	}
+	if(framer.cobsLeft == 0) {
+		// code byte. The block before ends in a 0x00 unless it was full
+		if(framer.cobsCode != 0xFF) {
+			framerField(0);
+		}
+		framer.cobsCode = byte;
+		framer.cobsLeft = byte - 1;
+		return;
+	}
+	framer.cobsLeft--;
+	framerField(byte);
+}
+#endif
+
+
+// one byte of the frame to the line, Hamming coded if set
+#if FRAMER_FEC == YES
+	#define framerPut(byte) fecTxByte(&fecTx, (byte), USink)
+#else
+	#define framerPut(byte) UWriteData(byte)
+#endif
+
+
+// sends TYPE ... CRCH, COBS encoded if set
+void framerSendBody(const uint8_t *body, uint8_t n) {
+	uint8_t i = 0;
+	#if FRAMER_FEC == YES
+		struct fecTx fecTx;
+		fecTxInit(&fecTx);
+	#endif
+	#if FRAMER_COBS == YES
+		uint8_t j;
+		uint8_t k;
+		// position n stands for the 0x00 that COBS adds at the end
+		while(i <= n) {
+			j = i;
+			while(j < n && body[j] != 0 && j - i < 254) {
+				j++;
+			}
+			framerPut(j - i + 1);
+			for(k=i; k<j; k++) {
+				framerPut(body[k]);
+			}
+			if(j - i == 254) {
+				i = j; // full block, no 0x00 stands behind it
+			}
+			else {
+				i = j + 1;
+			}
+		}
+		#if FRAMER_FEC == YES
+			fecTxEnd(&fecTx, USink);
+		#endif
+		UWriteData(0);
+	#else
+		UWriteData(FRAMER_SYNC1);
+		UWriteData(FRAMER_SYNC2);
+		#if FRAMER_FEC == YES
+			for(; i<n; i++) {
+				framerPut(body[i]);
+			}
+			fecTxEnd(&fecTx, USink);
+		#else
+			UWrite(body, n);
+		#endif
+	#endif
+}
+/*-------------------------------------------------------*/
+
+
+
+/******************* USER FUNCTIONS *******************/
+void framerInit() {
+	uint8_t i;
+	uint8_t sreg = SREG;
+	cli();
+	frameRingInit(&framer.free);
+	frameRingInit(&framer.ready);
+	for(i=0; i<FRAME_POOL; i++) {
+		frameRingPush(&framer.free, i);
+	}
+	#if FRAMER_COBS == YES
+		// as if a 0x00 just came, the line starts with a frame
+		framer.state = FR_TYPE;
+		framer.cobsLeft = 0;
+		framer.cobsCode = 0xFF;
+	#else
+		framer.state = FR_HUNT;
+	#endif
+	#if FRAMER_FEC == YES
+		fecRxInit(&framer.fecRx);
+	#endif
+	framer.hold = 0;
+	framer.badCrc = 0;
+	framer.badLen = 0;
+	framer.badType = 0;
+	framer.noFrame = 0;
+	SREG = sreg;
+}
+
+
+// called by the USART RX ISR for every good byte
+void framerRxByte(uint8_t byte) {
+	#if FRAMER_COBS == YES
+		if(byte == 0) {
+			// end of a frame, the next byte starts one
+			framer.state = FR_TYPE;
+			framer.cobsLeft = 0;
+			framer.cobsCode = 0xFF; // no 0x00 before the first block
+			#if FRAMER_FEC == YES
+				fecRxInit(&framer.fecRx);
+			#endif
+			return;
+		}
+		#if FRAMER_FEC == YES
+			fecRxByte(&framer.fecRx, byte, framerCobsByte);
+		#else
+			framerCobsByte(byte);
+		#endif
+	#else
+		switch(framer.state) {
+			case FR_HUNT:
+				if(byte == FRAMER_SYNC1) {
+					framer.state = FR_SYNC2;
+				}
+				break;
+
+			case FR_SYNC2:
+				if(byte == FRAMER_SYNC2) {
+					framer.state = FR_TYPE;
+					#if FRAMER_FEC == YES
+						fecRxInit(&framer.fecRx);
+					#endif
+				}
+				else if(byte != FRAMER_SYNC1) {
+					framer.state = FR_HUNT;
+				}
+				break;
+
+			default:
+				#if FRAMER_FEC == YES
+					fecRxByte(&framer.fecRx, byte, framerField);
+				#else
+					framerField(byte);
+				#endif
+				break;
+		}
+	#endif
+}
+
+
+// oldest complete frame, 0 if none. Stays valid till frameRelease()
+struct frame *framerGet() {
+	uint8_t no;
+	if(!frameRingPop(&framer.ready, &no)) {
+		return 0;
+	}
+	return &framePool[no];
+}
+
+
+void frameRelease(struct frame *f) {
+	frameRingPush(&framer.free, f - framePool);
+}
+
+
+void framerSend(uint8_t type, const void *data, uint8_t len) {
+	uint8_t body[FRAME_MAX_LEN + 4];
+	const uint8_t *src = data;
+	uint16_t crc;
+	uint8_t i;
+
+	if(len > FRAME_MAX_LEN) {
+		len = FRAME_MAX_LEN;
+	}
+	body[0] = type;
+	body[1] = len;
+	crc = _crc_ccitt_update(0xFFFF, type);
+	crc = _crc_ccitt_update(crc, len);
+	for(i=0; i<len; i++) {
+		body[2 + i] = src[i];
+		crc = _crc_ccitt_update(crc, src[i]);
+	}
+	body[2 + len] = lByte(crc);
+	body[3 + len] = hByte(crc);
+	framerSendBody(body, len + 4);
+}
+/*-----------------------------------------------------*/
+
+
+
+/******************* EXAMPLE CODE *******************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/int/usart/framer.h"	// includes usart.h
+#include "mega16/ext/lcd16x2/lcd.h"
+
+int main() {
+	struct frame *f;
+	uint8_t reply[2];
+
+	LCDInit(LS_NONE);
+	LCDClear();
+	framerInit();
+	USARTInit(9600);
+
+	while(1) {
+		while((f = framerGet())) {
+			if(f->type == 'C') {
+				// command: answer with the command bytes swapped
+				reply[0] = f->data[1];
+				reply[1] = f->data[0];
+				framerSend('C', reply, 2);
+			}
+			else if(f->type == 'T') {
+				LCDWriteIntXY(0, 0, f->len, 2);
+				LCDWriteIntXY(4, 0, f->data[0], 3);
+			}
+			frameRelease(f); // data is read in place, give it back
+		}
+		LCDWriteIntXY(0, 1, framer.badCrc, 3);
+		_delay_ms(50);
+	}
+}
+-----------------------------------------------------*/
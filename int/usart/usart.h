@@ -14,13 +14,58 @@ The array will hold just the data bytes and not the mask bytes
 After every successfull packet receive the array will be updated 
 with new values.
 
+Every packet also goes into a ring (RCV_PKT_DEPTH packets deep),
+so packets that come faster than the main loop reads them are
+not lost. UReadPacket() takes them out in order.
+
+Every received byte also goes into an RX ring (RX_DEPTH bytes), so
+a raw stream can be read as well, whatever the packet format is.
+The RX ISR is kept short for sustained 115200 baud streams. It
+counts what goes wrong:
+	uRx.dataOverrun => DOR, a byte was lost before the ISR ran
+	uRx.frameErr => FE, bad stop bit. The byte is thrown away
+	uRx.overrun => the RX ring was full, the byte is thrown away
+
+Sending is buffered as well. UWriteData(), UWrite() and UPrint()
+put the bytes in a TX ring (TX_DEPTH bytes) and return, the
+USART_UDRE interrupt feeds them to the hardware one by one. A
+64 byte message at 9600 baud costs a few hundred cycles instead
+of 67ms of waiting. When the ring is full "TX_WHEN_FULL" decides:
+	TX_BLOCK => wait till there is room (default)
+	TX_DROP  => throw the rest away and count it in uTx.dropped
+
 
 USER FUNCTIONS:
 	USARTInit(BaudRate); => Initializes Usart with specified Baud rate
 							also turns on the receive interrupt, and
 							global interrupt as well
 
-	UWriteData(byteToSend); => Sends an Atomic byte over TX of USART
+	USARTInitStatic(); => Same as USARTInit(USART_BAUD), but UBRR and
+						  U2X are worked out by the compiler. No
+						  division at run time, and a baud rate the
+						  clock can not make is a compile error
+	USARTSetBaud(BaudRate); => Changes the baud rate at run time
+
+	UWriteData(byteToSend); => Queues one byte for TX. Returns 0 if it
+							   was dropped (TX_DROP only)
+	UWrite(buf, len); => Queues len bytes, returns how many were queued
+	UPrint(string); => Queues a '\0' terminated string
+	UFlush(); => Waits till the last queued byte is out on the wire
+	UTxWaiting(); => Bytes in the TX ring not sent yet
+	UWrite_P(PSTR("text")); => Sends a string straight from flash
+	UWriteBlock_P(data_P, len); => Sends len bytes straight from flash
+	UPrintf("fmt", ...); => Formatted output through the TX ring,
+							format string in flash (see io/format.h)
+
+	UAvailable(); => Received bytes waiting in the RX ring
+	URead(&byte); => Takes the oldest received byte. 0 if none
+	UReadBlock(buf, len); => Takes upto len bytes, returns how many
+	URxFlush(); => Throws away all received bytes
+
+	UReadPacket(buf); => copies the oldest unread packet (RCV_PKT_LEN
+						 bytes) to buf. Returns 0 if there is none
+	UPacketsWaiting(); => number of unread packets
+	rcvPktLost => packets dropped because the ring was full
 	
 	avrRXoff() 	These macros are useful in power management. 
 	avrRXon()	programmers can make use of these and turn on
@@ -35,9 +80,60 @@ NOTE:
 	When using with RF module its found to be best performing with
 	baud rate 2400 and 4 of these "_delay_loop_2(0);" in every 
 	iteration of the send packet loop.
+	ext/rf433/rfLink.h sends packets over the same RF modules with
+	Manchester coding and a CRC, without the USART.
 
 	If you are using ATmega32 instead of ATmega16 then do set it up
 	in AVR studio project config option, else RF modules do not work
+
+	A header that defines "USART_RX_HOOK" as a function name before
+	including usart.h gets every good received byte from the RX ISR
+	(framer.h does so).
+
+	BAUD RATE: UBRR is rounded to the nearest value, in normal and in
+	double speed (U2X) mode, and the mode with the smaller error is
+	taken (normal if equal, it samples each bit 16 times instead of 8).
+	@16Mhz:	 9600 => normal, 0.2%	57600 => U2X, 0.8%
+			115200 => U2X, 2.1% 	(normal mode would be 3.5%)
+	USART_BAUD_ERR holds the error of USART_BAUD in per mille.
+	Above USART_BAUD_TOL the compile stops. Both ends together
+	should stay within about 4.5%.
+	When the rate of the other end is not known, autoBaud.h finds
+	it from one 0x55 and starts the USART with it.
+
+	MPCM (RS-485 multi-drop): with "USART_MPCM" as "YES" all nodes
+	use 9 bit frames. A frame with the 9th bit set is an address.
+	A slave (USART_NODE_ADDR not 0) keeps the hardware MPCM filter on,
+	so its RX ISR only runs for address frames, until its own address
+	(or USART_BROADCAST) comes. Then it takes data frames, till the
+	next address frame for another node. Idle slaves see one
+	interrupt per address instead of one per byte on the bus.
+	The master (USART_NODE_ADDR 0) takes every data frame and picks
+	the slave with UWriteAddress(). Address frames never reach the
+	RX ring, the packet filter or USART_RX_HOOK.
+		UWriteAddress(addr); => waits till the TX ring is empty, sends
+								addr as an address frame (master).
+								Interrupts are off for up to two
+								characters while it does
+		USetAddress(addr); => changes the own address (slave)
+		uMpcm.selected => 1 while this slave is addressed
+
+	FLASH: UWrite_P() and UWriteBlock_P() do not copy the bytes, not
+	even into the TX ring. They leave a pointer to the flash and a
+	length for the UDRE ISR, which reads the bytes from flash one by
+	one once the bytes queued before are out. A constant message so
+	costs no SRAM at all. Bytes queued after it wait in the ring as
+	usual. One flash block is sent at a time, a second UWrite_P()
+	waits till the first is done.
+
+	Writing with interrupts off (inside an ISR, after cli()) still
+	works: when the ring is full the byte at its head is sent by
+	polling, as the UDRE interrupt can not run. UWriteData() and
+	UWrite() put bytes in the ring with interrupts off, so an ISR
+	may write while main is writing as well. Its bytes then land in
+	between, not inside a byte of main. A UWrite() block can be
+	split by them when the ring fills up. Call UFlush() before
+	sleeping or turning TX off, else queued bytes are lost.
 ------------------------------------------------------------------------*/
 
 
@@ -48,10 +144,24 @@ NOTE:
 #ifndef GPIO
 	#include "../../io/gpio.h"
 #endif
+
+#ifndef RING_TYPE
+	#include "../../io/ring.h"
+#endif
+
+#ifndef FMT_HEX
+	#include "../../io/format.h"
+#endif
 #undef NO
 #undef YES
 #define YES 1
 #define NO 2
+
+// what UWriteData(), UWrite() do when the TX ring is full
+#define TX_BLOCK 1
+#define TX_DROP 2
+
+#define UBRR_MAX 4095 // 12 bit
 /*-----------------------------------------------------------------------*/
 
 
@@ -66,6 +176,52 @@ NOTE:
 // can be varied and here denoted by '0'(s) 
 volatile uint8_t rcvPacketFormat[] = { 'J', 'A', 'A', 0, 0, 0, 0, 'Z' };
 #define PKT_RX_FINISH_CALLBACK NO
+#define RCV_PKT_DEPTH 4 // packets kept till read. 2, 4, 8 ... 128
+#define TX_DEPTH 32 // bytes queued for sending. 2, 4, 8 ... 128
+#define TX_WHEN_FULL TX_BLOCK // TX_BLOCK, TX_DROP
+#define RX_STREAM YES // YES keeps every received byte in the RX ring
+#define RX_DEPTH 64 // received bytes kept till read. 2, 4, 8 ... 128
+#define USART_BAUD 9600 // baud rate of USARTInitStatic()
+#define USART_BAUD_TOL 25 // largest baud error allowed, per mille (25 => 2.5%)
+#define USART_MPCM NO // YES => 9 bit frames with MPCM addressing (RS-485 multi-drop)
+#define USART_NODE_ADDR 0x01 // own address, 0 => bus master (USART_MPCM YES only)
+#define USART_BROADCAST 0xFF // address every slave takes
+/*-----------------------------------------------------------------------*/
+
+
+
+
+/****************************** BAUD RATE ********************************/
+// nearest UBRR in normal (16 samples per bit) and U2X (8 samples) mode
+#define USART_UBRR_1X ((F_CPU + 8UL * USART_BAUD) / (16UL * USART_BAUD) - 1)
+#define USART_UBRR_2X ((F_CPU + 4UL * USART_BAUD) / (8UL * USART_BAUD) - 1)
+
+// error in per mille of a real baud rate against USART_BAUD
+#define USART_ERR(real) ((real) > USART_BAUD \
+	? ((real) - USART_BAUD) * 1000UL / USART_BAUD \
+	: (USART_BAUD - (real)) * 1000UL / USART_BAUD)
+#define USART_ERR_1X USART_ERR(F_CPU / (16UL * (USART_UBRR_1X + 1)))
+#define USART_ERR_2X USART_ERR(F_CPU / (8UL * (USART_UBRR_2X + 1)))
+
+#if (F_CPU + 4UL * USART_BAUD) / (8UL * USART_BAUD) == 0
+	#error USART_BAUD TOO HIGH FOR F_CPU
+#elif (F_CPU + 8UL * USART_BAUD) / (16UL * USART_BAUD) > UBRR_MAX + 1
+	#error USART_BAUD TOO LOW FOR F_CPU
+#endif
+
+#if USART_UBRR_2X <= UBRR_MAX && ((F_CPU + 8UL * USART_BAUD) / (16UL * USART_BAUD) == 0 || USART_ERR_2X < USART_ERR_1X)
+	#define USART_U2X 1
+	#define USART_UBRR USART_UBRR_2X
+	#define USART_BAUD_ERR USART_ERR_2X
+#else
+	#define USART_U2X 0
+	#define USART_UBRR USART_UBRR_1X
+	#define USART_BAUD_ERR USART_ERR_1X
+#endif
+
+#if USART_BAUD_ERR > USART_BAUD_TOL
+	#error USART_BAUD ERROR ABOVE USART_BAUD_TOL, TRY ANOTHER BAUD RATE OR CRYSTAL
+#endif
 /*-----------------------------------------------------------------------*/
 
 
@@ -74,6 +230,146 @@ volatile uint8_t rcvPacketFormat[] = { 'J', 'A', 'A', 0, 0, 0, 0, 'Z' };
 /******************************** GLOBAL *********************************/
 volatile uint8_t rcvPacket[RCV_PKT_LEN];  // holds the received packet(mask
 // bytes are not included).  
+
+struct rcvPkt {
+	uint8_t data[RCV_PKT_LEN];
+};
+RING_TYPE(rcvPktRing, struct rcvPkt, RCV_PKT_DEPTH)
+struct rcvPktRing rcvPkts; // every received packet, oldest first
+volatile uint8_t rcvPktLost = 0;
+
+RING_TYPE(uTxRing, uint8_t, TX_DEPTH)
+struct uTx {
+	struct uTxRing ring;	// bytes waiting to be sent
+	volatile uint8_t sent;	// something was sent since USARTInit
+	volatile uint8_t dropped;
+	const uint8_t *flash;		// flash block being sent
+	uint16_t flashLen;			// bytes of it left
+	uint8_t flashAfter;			// ring bytes to send before it
+	volatile uint8_t flashBusy;	// flash block waiting or going out
+} uTx;
+
+#if RX_STREAM == YES
+	RING_TYPE(uRxRing, uint8_t, RX_DEPTH)
+#endif
+struct uRx {
+	#if RX_STREAM == YES
+		struct uRxRing ring;	// received bytes, oldest first
+	#endif
+	volatile uint8_t overrun;		// ring full
+	volatile uint8_t dataOverrun;	// DOR from the hardware
+	volatile uint8_t frameErr;		// FE from the hardware
+} uRx;
+
+#if USART_MPCM == YES
+	struct uMpcm {
+		uint8_t address;			// own address, 0 on the master
+		volatile uint8_t selected;	// data frames are for this node
+	} uMpcm;
+#endif
+/*-----------------------------------------------------------------------*/
+
+
+
+
+/***************************** TX INTERNALS *****************************/
+// hands the next byte to the hardware, or stops the UDRE
+// interrupt when there is none. UDR must be empty
+static inline void uTxNext(void) {
+	uint8_t byte;
+	if(uTx.flashBusy && !uTx.flashAfter) {
+		// bytes queued before the flash block are out, its turn
+		byte = pgm_read_byte(uTx.flash++);
+		if(!--uTx.flashLen) {
+			uTx.flashBusy = 0;
+		}
+	}
+	else if(uTxRingPop(&uTx.ring, &byte)) {
+		if(uTx.flashBusy) {
+			uTx.flashAfter--;
+		}
+	}
+	else {
+		UCSRB &= ~(1<<UDRIE);
+		return;
+	}
+	UCSRA |= (1<<TXC); // cleared here, set again once all is out
+	UDR = byte;
+	uTx.sent = 1;
+}
+
+
+static inline void uSetUBRR(uint16_t ubrr, uint8_t u2x) {
+	if(u2x) {
+		UCSRA |= (1<<U2X);
+	}
+	else {
+		UCSRA &= ~(1<<U2X);
+	}
+	UBRRH = hByte(ubrr); // URSEL (bit 7) is 0, so this is UBRRH not UCSRC
+	UBRRL = lByte(ubrr);
+}
+
+
+// rings, frame format, RX and TX on. Baud rate is set before
+static inline void uStart(void) {
+	rcvPktRingInit(&rcvPkts);
+	uTxRingInit(&uTx.ring);
+	uTx.sent = 0;
+	uTx.dropped = 0;
+	uTx.flashBusy = 0;
+	#if RX_STREAM == YES
+		uRxRingInit(&uRx.ring);
+	#endif
+	uRx.overrun = 0;
+	uRx.dataOverrun = 0;
+	uRx.frameErr = 0;
+
+	// set data frame as 8bit long. UCSRC shares its address with
+	// UBRRH, URSEL picks UCSRC
+	UCSRC = (1<<URSEL) | (1<<UCSZ1) | (1<<UCSZ0);
+
+	#if USART_MPCM == YES
+		set(UCSRB, UCSZ2); // 9 bit
+		uMpcm.address = USART_NODE_ADDR;
+		uMpcm.selected = !USART_NODE_ADDR; // master takes all data frames
+		if(USART_NODE_ADDR) {
+			UCSRA = (UCSRA & ~(1<<TXC)) | (1<<MPCM); // wait for an address frame
+		}
+	#endif
+
+	set(UCSRB, RXEN);	// power up RX Module
+	set(UCSRB, TXEN);	// power up TX Module
+	set(UCSRB, RXCIE);  // Enable the USART Recieve Complete interrupt  ISR(USART_RXC_vect) {}
+ 	sei();
+}
+
+
+#if USART_MPCM == YES
+	// address frame came in. MPCM on unless it is for this node.
+	// UCSRA is written without TXC, writing it as 1 would clear it
+	static inline void uMpcmAddress(uint8_t address) {
+		if(!uMpcm.address) {
+			return; // master, takes data frames anyway
+		}
+		if(address == uMpcm.address || address == USART_BROADCAST) {
+			UCSRA = UCSRA & ~((1<<TXC) | (1<<MPCM));
+			uMpcm.selected = 1;
+		}
+		else {
+			UCSRA = (UCSRA & ~(1<<TXC)) | (1<<MPCM);
+			uMpcm.selected = 0;
+		}
+	}
+#endif
+
+
+// full ring with interrupts off: the UDRE ISR can not make room,
+// so do its work here
+static inline void uTxPoll(void) {
+	while(!(UCSRA & (1<<UDRE)));
+	uTxNext();
+}
 /*-----------------------------------------------------------------------*/
 
 
@@ -83,37 +379,251 @@ volatile uint8_t rcvPacket[RCV_PKT_LEN];  // holds the received packet(mask
 
 /***************************** USER FUNCTIONS *****************************/
 
+// picks normal or U2X mode, whichever is nearer to baudrate.
+// Run time twin of the BAUD RATE section. Call UFlush() first
+// when changing the rate of a running USART. A rate out of reach
+// gets the nearest one the USART can do
+void USARTSetBaud(uint32_t baudrate) {
+	uint32_t ubrr1x = (F_CPU + 8UL * baudrate) / (16UL * baudrate);	// UBRR + 1
+	uint32_t ubrr2x = (F_CPU + 4UL * baudrate) / (8UL * baudrate);
+	uint32_t real1x;
+	uint32_t real2x;
+
+	if(!ubrr2x) {
+		uSetUBRR(0, 1); // too fast for any mode, fastest there is
+		return;
+	}
+	if(ubrr2x > UBRR_MAX + 1) {
+		// too slow for U2X. Below the slowest normal rate (about 245
+		// baud at 16Mhz) UBRR stays at its largest, the high bits
+		// would end up in URSEL and the write in UCSRC
+		uSetUBRR(ubrr1x > UBRR_MAX + 1 ? UBRR_MAX : ubrr1x - 1, 0);
+		return;
+	}
+	if(!ubrr1x) {
+		uSetUBRR(ubrr2x - 1, 1); // too fast for normal mode
+		return;
+	}
+	real1x = F_CPU / (16UL * ubrr1x);
+	real2x = F_CPU / (8UL * ubrr2x);
+	// distance to baudrate, same scale for both
+	real1x = real1x > baudrate ? real1x - baudrate : baudrate - real1x;
+	real2x = real2x > baudrate ? real2x - baudrate : baudrate - real2x;
+	if(real2x < real1x) {
+		uSetUBRR(ubrr2x - 1, 1);
+	}
+	else {
+		uSetUBRR(ubrr1x - 1, 0);
+	}
+}
+
+
 // initialize this function with required baud rate
 void USARTInit(uint32_t baudrate) {
-	set(UCSRB, RXEN);	// power up RX Module
-	set(UCSRB, TXEN);	// power up TX Module
+	USARTSetBaud(baudrate);
+	uStart();
+}
 
-   	// set data frame as 8bit long
-	set(UCSRC, UCSZ1);
-	set(UCSRC, UCSZ0);
-	set(UCSRC, URSEL);
 
-	// Calculate UBRR value acording to the baud rate
-	uint16_t ubrrVal = (((F_CPU / (baudrate * 16UL))) - 1);
-	
-	// Set UBRR value
-	UBRRH = hByte(ubrrVal); // Load upper 8-bits of the baud rate value into the high byte of the UBRR register
-	UBRRL = lByte(ubrrVal); // Load lower 8-bits of the baud rate value into the low byte of the UBRR register
+// USARTInit(USART_BAUD) with UBRR and U2X from the compiler
+void USARTInitStatic() {
+	uSetUBRR(USART_UBRR, USART_U2X);
+	uStart();
+}
 
-	set(UCSRB, RXCIE);  // Enable the USART Recieve Complete interrupt  ISR(USART_RXC_vect) {}
- 	sei();
+
+/* This function queues data for TX. The UDRE ISR sends it.
+   The push runs with interrupts off, so main and ISRs may all write */
+uint8_t UWriteData(char data) {
+	uint8_t sreg;
+	uint8_t ok;
+	while(1) {
+		sreg = SREG;
+		cli();
+		ok = uTxRingPush(&uTx.ring, data);
+		if(ok) {
+			UCSRB |= (1<<UDRIE); // ISR starts sending (if not already)
+		}
+		SREG = sreg;
+		if(ok) {
+			return 1;
+		}
+		#if TX_WHEN_FULL == TX_DROP
+			uTx.dropped++;
+			return 0;
+		#else
+			if(!(sreg & (1<<SREG_I))) {
+				uTxPoll();
+			}
+		#endif
+	}
 }
 
 
-/* This function sends data  through TX */
-void UWriteData(char data) {
-	//Wait For Transmitter to become ready
-	while(!(UCSRA & (1<<UDRE)));
-	//Now write
-	UDR=data;
+/* queues len bytes. Returns how many were queued */
+uint8_t UWrite(const void *buf, uint8_t len) {
+	const uint8_t *src = buf;
+	uint8_t done = 0;
+	uint8_t sreg;
+	uint8_t n;
+	while(done < len) {
+		sreg = SREG;
+		cli();
+		n = uTxRingPushBlock(&uTx.ring, src + done, len - done);
+		if(n) {
+			UCSRB |= (1<<UDRIE);
+		}
+		SREG = sreg;
+		if(n) {
+			done += n;
+			continue;
+		}
+		#if TX_WHEN_FULL == TX_DROP
+			uTx.dropped += len - done;
+			break;
+		#else
+			if(!(sreg & (1<<SREG_I))) {
+				uTxPoll();
+			}
+		#endif
+	}
+	return done;
+}
+
+
+/* sends len bytes from flash. Nothing is copied, the UDRE ISR reads
+   them from flash when their turn comes */
+void UWriteBlock_P(const void *data, uint16_t len) {
+	uint8_t sreg;
+	if(!len) {
+		return;
+	}
+	while(uTx.flashBusy) { // one flash block at a time
+		if(!(SREG & (1<<SREG_I))) {
+			uTxPoll();
+		}
+	}
+	sreg = SREG;
+	cli(); // the ISR must not send a ring byte while they are counted
+	uTx.flash = data;
+	uTx.flashLen = len;
+	uTx.flashAfter = uTxRingCount(&uTx.ring);
+	uTx.flashBusy = 1;
+	UCSRB |= (1<<UDRIE);
+	SREG = sreg;
+}
+
+
+/* sends a '\0' terminated string from flash, e.g. UWrite_P(PSTR("ok\r\n")) */
+void UWrite_P(const char *str) {
+	UWriteBlock_P(str, strlen_P(str));
+}
+
+
+/* queues a string, without the '\0' */
+void UPrint(const char *str) {
+	while(*str) {
+		UWriteData(*str++);
+	}
 }
 
 
+/* waits till every queued byte has left the TX pin */
+void UFlush() {
+	while(UCSRB & (1<<UDRIE)) {
+		if(!(SREG & (1<<SREG_I))) {
+			uTxPoll();
+		}
+	}
+	if(uTx.sent) {
+		while(!(UCSRA & (1<<TXC)));
+	}
+}
+
+
+#define UTxWaiting() uTxRingCount(&uTx.ring)
+
+
+#if USART_MPCM == YES
+	/* sends an address frame. The 9th bit can not wait in the TX
+	   ring with the byte, so the ring is sent out first */
+	void UWriteAddress(uint8_t address) {
+		uint8_t sreg;
+		while(1) {
+			sreg = SREG;
+			cli();
+			if(!(UCSRB & (1<<UDRIE))) {
+				break; // ring empty, interrupts stay off
+			}
+			SREG = sreg;
+			if(!(sreg & (1<<SREG_I))) {
+				uTxPoll();
+			}
+		}
+		// no ISR can queue a byte (and set UDRIE) till TXB8 is clear
+		// again, else that data byte would go out as an address
+		while(!(UCSRA & (1<<UDRE)));
+		UCSRA |= (1<<TXC);
+		UCSRB |= (1<<TXB8);
+		UDR = address;
+		uTx.sent = 1;
+		while(!(UCSRA & (1<<UDRE))); // address and 9th bit are in the shift register
+		UCSRB &= ~(1<<TXB8);
+		SREG = sreg;
+	}
+
+
+	/* own address of a slave. The node waits for its next address frame */
+	void USetAddress(uint8_t address) {
+		uint8_t sreg = SREG;
+		cli();
+		uMpcm.address = address;
+		uMpcm.selected = !address;
+		if(address) {
+			UCSRA = (UCSRA & ~(1<<TXC)) | (1<<MPCM);
+		}
+		else {
+			UCSRA = UCSRA & ~((1<<TXC) | (1<<MPCM));
+		}
+		SREG = sreg;
+	}
+#endif
+
+
+/* sink for io/format.h */
+void USink(uint8_t c) {
+	UWriteData(c);
+}
+
+
+#define UPrintf(fmt, ...) fmtPrint_P(USink, PSTR(fmt), ##__VA_ARGS__)
+
+
+#if RX_STREAM == YES
+	#define UAvailable() uRxRingCount(&uRx.ring)
+	#define URead(byte) uRxRingPop(&uRx.ring, (byte))
+	#define UReadBlock(buf, len) uRxRingPopBlock(&uRx.ring, (buf), (len))
+	#define URxFlush() uRxRingFlush(&uRx.ring)
+#endif
+
+
+/* takes the oldest packet out of the ring. Returns 0 if none came */
+uint8_t UReadPacket(uint8_t *buf) {
+	struct rcvPkt pkt;
+	uint8_t i;
+	if(!rcvPktRingPop(&rcvPkts, &pkt)) {
+		return 0;
+	}
+	for(i=0; i<RCV_PKT_LEN; i++) {
+		buf[i] = pkt.data[i];
+	}
+	return 1;
+}
+
+
+#define UPacketsWaiting() rcvPktRingCount(&rcvPkts)
+
+
 /* power on and power off the Internal USART RX and TX modules to save power */
 #define avrRXoff() (UCSRB &= ~(1<<RXEN))
 #define avrRXon() (UCSRB |= (1<<RXEN))
@@ -128,7 +638,7 @@ void UWriteData(char data) {
 
 
 /*************** Global Variables Intermidiate(temporary) ************************/
-volatile uint8_t rcvDockTmp[RCV_PKT_LEN];// temporary docking place
+struct rcvPkt rcvDockTmp; // temporary docking place, ISR only
 volatile uint8_t rcvPacketIndex = 0;
 volatile uint8_t prevRcvByte = 0;
 volatile uint8_t newRcvByte = 0;
@@ -148,14 +658,47 @@ volatile uint8_t newRcvByte = 0;
 
 
 /****************************** RX Interrupt Vector ******************************/
-ISR(USART_RXC_vect) {
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_USART_RXC
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(USART_RXC_vect)
+#endif
+{
+	uint8_t status = UCSRA; // FE and DOR belong to the byte in UDR, read them first
+	#if USART_MPCM == YES
+		uint8_t bit9 = UCSRB & (1<<RXB8); // so does RXB8
+	#endif
 
 	newRcvByte = UDR;
 	//UDR = newByte; //  echos the received byte
+
+	if(status & (1<<DOR)) {
+		uRx.dataOverrun++; // this byte is fine, one before it was lost
+	}
+	if(status & (1<<FE)) {
+		uRx.frameErr++;
+		return;
+	}
+	#if USART_MPCM == YES
+		if(bit9) {
+			uMpcmAddress(newRcvByte);
+			return;
+		}
+	#endif
+	#if RX_STREAM == YES
+		if(!uRxRingPush(&uRx.ring, newRcvByte)) {
+			uRx.overrun++;
+		}
+	#endif
+	#ifdef USART_RX_HOOK
+		USART_RX_HOOK(newRcvByte); // e.g. framer.h
+	#endif
 	
 	// store just the data bytes (not mask bytes)
 	if(rcvPacketIndex>=2 && rcvPacketIndex < RCV_PKT_LEN+2 ){
-		rcvDockTmp[rcvPacketIndex-2] = newRcvByte;
+		rcvDockTmp.data[rcvPacketIndex-2] = newRcvByte;
 		rcvPacketIndex++;
 		return;
 	}
@@ -182,7 +725,10 @@ ISR(USART_RXC_vect) {
 		case Z_CASE_NUM:
 			if(newRcvByte == rcvPacketFormat[RCV_PKT_LEN+3] ) { // successfull 
 				for(rcvPacketIndex = 0; rcvPacketIndex < RCV_PKT_LEN; rcvPacketIndex++) {
-					rcvPacket[rcvPacketIndex] = rcvDockTmp[rcvPacketIndex]; // copy data from temporary dock to the final packet
+					rcvPacket[rcvPacketIndex] = rcvDockTmp.data[rcvPacketIndex]; // copy data from temporary dock to the final packet
+				}
+				if(!rcvPktRingPush(&rcvPkts, rcvDockTmp)) {
+					rcvPktLost++;
 				}
 				/*<<<<<<<<<<<<< This application specific code starts  <<<<<<<<<<<<<*/
 				#if PKT_RX_FINISH_CALLBACK == YES
@@ -202,6 +748,22 @@ ISR(USART_RXC_vect) {
 
 
 
+/****************************** TX Interrupt Vector ******************************/
+#ifdef ISR_DISPATCH
+	#define ISR_CLAIM_USART_UDRE
+	#include "../isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(USART_UDRE_vect)
+#endif
+{
+	uTxNext();
+}
+/*-------------------------------------------------------------------------------*/
+
+
+
+
 
 
 
@@ -220,12 +782,59 @@ int main() {
 
     USARTInit(2400);
     
+    uint8_t pkt[RCV_PKT_LEN];
+    uint8_t byte;
+
     while(1) { 
+        while(UReadPacket(pkt)) {
+            LCDWriteIntXY(8, 0, pkt[0], 3); // every packet, none skipped
+        }
         LCDWriteIntXY(0, 0, rcvPacket[0], 2);
         UWriteData('A'); // send byte
 		    LCDWriteIntXY(0, 1, rcvPacket[3], 3);
         UWriteData(23);  // send byte
+        UPrint("status ok\r\n"); // returns at once, sent by the ISR
+        while(URead(&byte)) {
+            UWriteData(byte); // echo every byte, packet or not
+        }
         _delay_ms(100);
     }
 }
----------------------------------------------------------------------------------*/
\ No newline at end of file
+---------------------------------------------------------------------------------*/
+
+
+/**************************** EXAMPLE CODE MPCM ***********************************
+// RS-485 bus, USART_MPCM YES. The master asks slave 2 and 3 in turn,
+// each slave answers with its own reading. Slaves are built with
+// USART_NODE_ADDR 2 and 3, the master with 0
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/int/usart/usart.h"
+#include "mega16/int/adc/adc.h"
+
+int main() {
+    uint8_t byte;
+    USARTInit(38400);
+
+    #if USART_NODE_ADDR == 0
+        uint8_t slave = 2;
+        while(1) {
+            UWriteAddress(slave);   // only this slave wakes up
+            UWriteData('?');        // data frame, goes to slave only
+            _delay_ms(20);
+            while(URead(&byte)) {
+                // answer of the slave
+            }
+            slave = (slave == 2) ? 3 : 2;
+        }
+    #else
+        initADC(ADC_AVCC);
+        while(1) {
+            if(URead(&byte) && byte == '?') {
+                UPrintf("%u\r\n", adcResults[4]); // 9th bit 0, a data frame
+            }
+        }
+    #endif
+}
+---------------------------------------------------------------------------------*/
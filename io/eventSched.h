@@ -0,0 +1,237 @@
+/******************** DESCRIPTION ********************
+A small event driven scheduler. Instead of a main loop full of
+_delay_ms() and polling, the drivers post events from their
+callbacks and main() hands control over to schedRun().
+
+schedRun() takes the oldest event of the most urgent level and
+calls sched_callback(event, arg) with it. Every event runs to
+completion, there is no preemption between events, so no
+locking is needed among them. When all queues are empty the CPU
+is put to SLEEP_MODE_IDLE. Timers, USART, ADC, TWI and INTx keep
+running in idle and the next interrupt wakes it up again.
+
+An event is just a number (0..255) picked by the programmer
+plus a 16 bit argument (a byte received, an ADC result, ...).
+
+USER FUNCTIONS:
+	1. schedInit(); 				=> empties the queues, selects idle sleep
+	2. schedPost(0, EV_KEY, arg); 	=> post from an ISR callback or main
+	3. schedRun(); 					=> dispatches events forever, never returns
+	4. schedStep(); 				=> dispatches one event. 0 if there was none
+	5. schedPending(); 				=> non zero if any event is waiting
+
+HOOKING THE DRIVERS:
+	USART		=> packetReceved_callpack()	(PKT_RX_FINISH_CALLBACK YES)
+	T2timeKeeper=> timekeeper_ms_callback()	(or _s_, _m_ ...)
+	INTx 		=> int0_Callback(), int1_Callback(), int2_Callback()
+	ADC 		=> adc_callback()			(ADC_CONV_CALLBACK YES)
+	Each of them posts one event and returns. See example code.
+
+NOTE:
+	The programmer has to define
+	"void sched_callback(uint8_t event, uint16_t arg)"
+	or else the library WILL NOT COMPILE.
+	schedPost() returns 0 and counts it in sched.dropped if the
+	queue of that level is full.
+	Level 0 is the most urgent one.
+----------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#undef YES
+#undef NO
+#define YES 1
+#define NO 2
+/*------------------------------------------------------*/
+
+
+
+/******************* USER CONFIGURABLE *******************/
+#define SCHED_LEVELS 2			// priority levels
+#define SCHED_QUEUE_LEN 8		// events per level. 2, 4, 8 ... 128
+#define SCHED_SLEEP_WHEN_IDLE YES	// NO keeps the CPU spinning (debugging)
+/*-------------------------------------------------------*/
+
+
+
+/********************* DEPENDENCY *********************/
+#include <avr/sleep.h>
+
+#if (SCHED_QUEUE_LEN & (SCHED_QUEUE_LEN - 1)) || SCHED_QUEUE_LEN > 128
+	#error SCHED_QUEUE_LEN MUST BE A POWER OF 2 UPTO 128
+#endif
+#define SCHED_WRAP (SCHED_QUEUE_LEN - 1)
+/*----------------------------------------------------*/
+
+
+
+/*********************** GLOBAL ***********************/
+struct schedQueue {
+	volatile uint8_t event[SCHED_QUEUE_LEN];
+	volatile uint16_t arg[SCHED_QUEUE_LEN];
+	volatile uint8_t head;
+	volatile uint8_t tail;
+};
+
+struct sched {
+	struct schedQueue queue[SCHED_LEVELS];
+	volatile uint8_t dropped;
+} sched;
+/*----------------------------------------------------*/
+
+
+
+/********************* PROTOTYPES *********************/
+void sched_callback(uint8_t event, uint16_t arg);
+/*----------------------------------------------------*/
+
+
+
+/******************* USER FUNCTIONS *******************/
+void schedInit() {
+	uint8_t i;
+	cli();
+	for(i=0; i<SCHED_LEVELS; i++) {
+		sched.queue[i].head = 0;
+		sched.queue[i].tail = 0;
+	}
+	sched.dropped = 0;
+	set_sleep_mode(SLEEP_MODE_IDLE);
+	sei();
+}
+
+
+// safe from ISR and from main
+uint8_t schedPost(uint8_t level, uint8_t event, uint16_t arg) {
+	struct schedQueue *q = &sched.queue[level];
+	uint8_t sreg = SREG;
+	uint8_t head;
+	uint8_t next;
+
+	cli();
+	head = q->head;
+	next = (head + 1) & SCHED_WRAP;
+	if(next == q->tail) {
+		sched.dropped++;
+		SREG = sreg;
+		return 0;
+	}
+	q->event[head] = event;
+	q->arg[head] = arg;
+	q->head = next;
+	SREG = sreg;
+	return 1;
+}
+
+
+uint8_t schedPending() {
+	uint8_t i;
+	for(i=0; i<SCHED_LEVELS; i++) {
+		if(sched.queue[i].head != sched.queue[i].tail) {
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+uint8_t schedStep() {
+	uint8_t i;
+	for(i=0; i<SCHED_LEVELS; i++) {
+		struct schedQueue *q = &sched.queue[i];
+		uint8_t tail = q->tail;
+		if(tail != q->head) {
+			uint8_t event = q->event[tail];
+			uint16_t arg = q->arg[tail]; // slot is not reused before tail moves on
+			q->tail = (tail + 1) & SCHED_WRAP;
+			sched_callback(event, arg);
+			return 1;
+		}
+	}
+	return 0;
+}
+
+
+void schedRun() {
+	while(1) {
+		if(schedStep()) {
+			continue;
+		}
+		#if SCHED_SLEEP_WHEN_IDLE == YES
+			// an ISR may post between the check and sleep_cpu(). sei
+			// takes effect after the next instruction, so the wake
+			// up interrupt is served only once the CPU is asleep
+			cli();
+			if(!schedPending()) {
+				sleep_enable();
+				sei();
+				sleep_cpu();
+				sleep_disable();
+			}
+			sei();
+		#endif
+	}
+}
+/*-----------------------------------------------------*/
+
+
+
+/******************* EXAMPLE CODE *******************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/io/eventSched.h"
+#include "mega16/int/intr/int0.h"
+#include "mega16/int/timer2/T2timeKeeper.h"
+#include "mega16/int/usart/usart.h"
+#include "mega16/ext/lcd16x2/lcd.h"
+
+#define EV_KEY 0
+#define EV_TICK 1
+#define EV_PACKET 2
+
+volatile uint8_t keys;
+
+// ISR side, post and leave
+void int0_Callback() {
+	schedPost(0, EV_KEY, 0);
+}
+
+// S_CALLBACK and PKT_RX_FINISH_CALLBACK are YES in the drivers
+void timekeeper_s_callback() {
+	schedPost(1, EV_TICK, time.s);
+}
+
+void packetReceved_callpack() {
+	schedPost(1, EV_PACKET, rcvPacket[0]);
+}
+
+// all the work, one event at a time
+void sched_callback(uint8_t event, uint16_t arg) {
+	switch(event) {
+		case EV_KEY:
+			keys++;
+			LCDWriteIntXY(0,0,keys,3);
+			break;
+
+		case EV_TICK:
+			LCDWriteIntXY(0,1,arg,2);
+			break;
+
+		case EV_PACKET:
+			LCDWriteIntXY(5,0,arg,3);
+			break;
+	}
+}
+
+int main() {
+	LCDInit(LS_NONE);
+	LCDClear();
+	schedInit();
+	int0Init();
+	initT2timeKeeper();
+	USARTInit(9600);
+	schedRun(); // sleeps whenever there is nothing to do
+}
+-----------------------------------------------------*/
@@ -0,0 +1,349 @@
+/******************** DESCRIPTION ********************
+Small printf for USART, soft USART and LCD. avr-libc printf
+pulls in a few kB and divides by 10 with a 32 bit division for
+every digit. Here the format string stays in flash, numbers are
+cut into digits by shifts and adds (no division), and every
+character goes straight to a sink function, so no buffer and no
+heap is needed:
+
+	void sink(uint8_t c);	// UWriteData, LCDData, ...
+
+	fmtPrint(sink, "T=%.1d C  n=%5u\r\n", 253, n);	=> "T=25.3 C  n=   42"
+
+FORMAT:
+	%d %i	=> int				%ld		=> int32_t
+	%u		=> unsigned int		%lu		=> uint32_t
+	%x %X	=> hex, 16 bit		%lx %lX	=> hex, 32 bit
+	%c		=> char				%%		=> '%'
+	%s		=> string in RAM	%S		=> string in flash (PSTR)
+	(width and '-' work on strings too)
+
+	Between % and the letter (in this order, all optional):
+	-		=> left aligned in the field
+	0		=> fill with '0' instead of ' '
+	width	=> field width, e.g. %5d
+	.N		=> fixed point, the last N digits come after a '.'
+			   e.g. %.2d of 1234 => "12.34", of 5 => "0.05"
+
+USER FUNCTIONS:
+	1. fmtPrint(sink, "fmt", ...); 		=> format string literal, kept in flash
+	2. fmtPrint_P(sink, fmt_P, ...); 	=> format string already in flash
+	3. fmtNumber(sink, value, flags, width, point);
+										=> one number, flags FMT_NEG, FMT_ZERO,
+										   FMT_LEFT, FMT_HEX, FMT_UPPER
+
+READY SINKS:
+	usart.h 		=> UPrintf("fmt", ...)
+	softUSART.h 	=> softUSARTPrintf(&usart, "fmt", ...)
+	lcd.h 			=> LCDPrintf("fmt", ...), LCDWriteInt(), LCDWriteLInt()
+
+NOTE:
+	An int is 16 bit on the AVR, 32 bit values need the 'l'.
+	Cutting a 32 bit number into digits takes about 1/4 of the
+	time of the avr-libc way. Numbers that fit in 16 bit take the
+	cheaper 16 bit path after the first digits.
+----------------------------------------------------*/
+
+
+
+/*********************** DEPENDENCY ***********************/
+#include <stdarg.h>
+#include <avr/pgmspace.h>
+/*--------------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+// fmtNumber() flags
+#define FMT_NEG 1		// print a '-'
+#define FMT_ZERO 2		// pad with '0'
+#define FMT_LEFT 4		// pad on the right
+#define FMT_HEX 8
+#define FMT_UPPER 16	// A-F instead of a-f
+/*------------------------------------------------------*/
+
+
+
+/************************* GLOBAL *************************/
+typedef void (*fmtSink)(uint8_t c);
+/*--------------------------------------------------------*/
+
+
+
+/*********************** INTERNALS ***********************/
+// n / 10 without a division. q = n * 0.8 by shifts (error below
+// one), / 8, then one correction step. The remainder comes for free
+static inline uint32_t fmtDivu10(uint32_t n, uint8_t *rem) {
+	uint32_t q = (n >> 1) + (n >> 2);
+	uint8_t r;
+	q += q >> 4;
+	q += q >> 8;
+	q += q >> 16;
+	q >>= 3;
+	r = n - (((q << 2) + q) << 1); // n - q*10, small
+	if(r > 9) {
+		q++;
+		r -= 10;
+	}
+	*rem = r;
+	return q;
+}
+
+
+static inline uint16_t fmtDivu10_16(uint16_t n, uint8_t *rem) {
+	uint16_t q = (n >> 1) + (n >> 2);
+	uint8_t r;
+	q += q >> 4;
+	q += q >> 8;
+	q >>= 3;
+	r = n - (((q << 2) + q) << 1);
+	if(r > 9) {
+		q++;
+		r -= 10;
+	}
+	*rem = r;
+	return q;
+}
+
+
+static inline void fmtPad(fmtSink sink, uint8_t c, uint8_t n) {
+	while(n--) {
+		sink(c);
+	}
+}
+
+
+// string in RAM or flash, padded with ' ' to width
+void fmtString(fmtSink sink, const char *str, uint8_t inFlash, uint8_t flags, uint8_t width) {
+	uint8_t len = 0;
+	uint8_t pad = 0;
+	char c;
+	if(width) {
+		while(inFlash ? pgm_read_byte(str + len) : str[len]) {
+			len++;
+		}
+		if(width > len) {
+			pad = width - len;
+		}
+	}
+	if(!(flags & FMT_LEFT)) {
+		fmtPad(sink, ' ', pad);
+	}
+	while((c = inFlash ? pgm_read_byte(str) : *str)) {
+		sink(c);
+		str++;
+	}
+	if(flags & FMT_LEFT) {
+		fmtPad(sink, ' ', pad);
+	}
+}
+/*-------------------------------------------------------*/
+
+
+
+/******************* USER FUNCTIONS *******************/
+void fmtNumber(fmtSink sink, uint32_t value, uint8_t flags, uint8_t width, uint8_t point) {
+	char digit[10];	// lowest first
+	uint8_t n = 0;
+	uint8_t len;
+	uint8_t pad = 0;
+	uint8_t r;
+
+	if(flags & FMT_HEX) {
+		do {
+			r = value & 0x0F;
+			if(r < 10) {
+				digit[n++] = '0' + r;
+			}
+			else {
+				digit[n++] = (flags & FMT_UPPER ? 'A' : 'a') + r - 10;
+			}
+			value >>= 4;
+		} while(value);
+	}
+	else {
+		uint16_t low;
+		while(value > 0xFFFF) {
+			value = fmtDivu10(value, &r);
+			digit[n++] = '0' + r;
+		}
+		low = value;
+		do {
+			low = fmtDivu10_16(low, &r);
+			digit[n++] = '0' + r;
+		} while(low);
+	}
+
+	// fixed point: at least one digit before the '.'
+	if(point > 9) {
+		point = 9;
+	}
+	while(point && n <= point) {
+		digit[n++] = '0';
+	}
+
+	len = n;
+	if(point) {
+		len++;
+	}
+	if(flags & FMT_NEG) {
+		len++;
+	}
+	if(width > len) {
+		pad = width - len;
+	}
+
+	if(!(flags & (FMT_LEFT | FMT_ZERO))) {
+		fmtPad(sink, ' ', pad);
+	}
+	if(flags & FMT_NEG) {
+		sink('-');
+	}
+	if((flags & (FMT_LEFT | FMT_ZERO)) == FMT_ZERO) {
+		fmtPad(sink, '0', pad); // after the sign
+	}
+	while(n) {
+		n--;
+		if(point && n == point - 1) {
+			sink('.');
+		}
+		sink(digit[n]);
+	}
+	if(flags & FMT_LEFT) {
+		fmtPad(sink, ' ', pad);
+	}
+}
+
+
+void fmtVPrint_P(fmtSink sink, const char *fmt, va_list ap) {
+	char c;
+	uint8_t flags;
+	uint8_t width;
+	uint8_t point;
+	uint8_t isLong;
+	uint32_t value;
+
+	while((c = pgm_read_byte(fmt++))) {
+		if(c != '%') {
+			sink(c);
+			continue;
+		}
+		flags = 0;
+		width = 0;
+		point = 0;
+		isLong = 0;
+
+		c = pgm_read_byte(fmt++);
+		if(c == '-') {
+			flags |= FMT_LEFT;
+			c = pgm_read_byte(fmt++);
+		}
+		if(c == '0') {
+			flags |= FMT_ZERO;
+			c = pgm_read_byte(fmt++);
+		}
+		while(c >= '0' && c <= '9') {
+			width = width * 10 + c - '0';
+			c = pgm_read_byte(fmt++);
+		}
+		if(c == '.') {
+			c = pgm_read_byte(fmt++);
+			while(c >= '0' && c <= '9') {
+				point = point * 10 + c - '0';
+				c = pgm_read_byte(fmt++);
+			}
+		}
+		if(c == 'l') {
+			isLong = 1;
+			c = pgm_read_byte(fmt++);
+		}
+
+		switch(c) {
+			case 'd':
+			case 'i': {
+				int32_t s = isLong ? va_arg(ap, int32_t) : va_arg(ap, int);
+				if(s < 0) {
+					flags |= FMT_NEG;
+					value = -(uint32_t)s;
+				}
+				else {
+					value = s;
+				}
+				fmtNumber(sink, value, flags, width, point);
+				break;
+			}
+
+			case 'X':
+				flags |= FMT_UPPER;
+				// fall through
+			case 'x':
+				flags |= FMT_HEX;
+				point = 0;
+				// fall through
+			case 'u':
+				value = isLong ? va_arg(ap, uint32_t) : va_arg(ap, unsigned int);
+				fmtNumber(sink, value, flags, width, point);
+				break;
+
+			case 'c':
+				sink(va_arg(ap, int));
+				break;
+
+			case 's':
+				fmtString(sink, va_arg(ap, const char *), 0, flags, width);
+				break;
+
+			case 'S':
+				fmtString(sink, va_arg(ap, const char *), 1, flags, width);
+				break;
+
+			case '\0':
+				return; // '%' at the very end
+
+			default: // "%%" and anything not known
+				sink(c);
+				break;
+		}
+	}
+}
+
+
+void fmtPrint_P(fmtSink sink, const char *fmt, ...) {
+	va_list ap;
+	va_start(ap, fmt);
+	fmtVPrint_P(sink, fmt, ap);
+	va_end(ap);
+}
+
+
+#define fmtPrint(sink, fmt, ...) fmtPrint_P((sink), PSTR(fmt), ##__VA_ARGS__)
+/*-----------------------------------------------------*/
+
+
+
+/******************* EXAMPLE CODE *******************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/int/usart/usart.h"	// includes format.h
+#include "mega16/int/adc/adc.h"
+#include "mega16/ext/lcd16x2/lcd.h"
+
+int main() {
+	uint16_t mv;
+	uint32_t n = 0;
+
+	USARTInit(9600);
+	LCDInit(LS_NONE);
+	LCDClear();
+	initADC(ADC_AVCC);
+
+	while(1) {
+		mv = (uint32_t)adcResults[4] * 5000 / 1024;
+		UPrintf("%lu: %.3u V (0x%03X)\r\n", n++, mv, adcResults[4]);	// "17: 2.346 V (0x1E0)"
+		LCDGotoXY(0, 0);
+		LCDPrintf("%-6S%.3u V", PSTR("ADC4"), mv);						// "ADC4  2.346 V"
+		_delay_ms(500);
+	}
+}
+-----------------------------------------------------*/
@@ -0,0 +1,380 @@
+/******************** DESCRIPTION ********************
+This library turns the MCU into a small logic analyser. It
+watches one 8 bit port (all 8 pins or a mask of them) and
+records what the pins did into a ring in SRAM. Once the capture
+is stopped the ring can be streamed out over USART to a PC.
+
+The record is run length encoded. Every entry is a pair
+(value, duration): the port had "value" for "duration" ticks.
+A pin that does not move costs nothing but one counter.
+
+Two capture modes are there
+	TRACE_SAMPLED	=> Timer0 in CTC mode samples the port at a
+					   fixed rate (TRACE_RATE). 100 Khz and more
+					   at 16Mhz. Duration is in samples.
+	TRACE_EDGE		=> the port is read on every edge of INT0,
+					   INT1 or INT2 and stamped with Timer1 free
+					   running at 2 Mhz. Duration is in 0.5us.
+
+USER FUNCTIONS:
+	1. traceInit(); 	=> sets up the timer and the edge interrupt
+	2. traceStart(); 	=> clears the ring and starts capturing
+	3. traceStop(); 	=> stops capturing, closes the last run
+	4. traceRuns(); 	=> number of (value, duration) pairs held
+	5. traceDump(); 	=> sends the capture out over USART
+
+DUMP FORMAT (all multi byte values little endian):
+	'L' 'A' mode mask rate(4 bytes, ticks per second) runs(2 bytes)
+	followed by "runs" times: value duration(2 bytes)
+	Oldest run comes first.
+
+NOTE:
+	USARTInit() has to be called before traceDump().
+	The pins are only read, DDR and PORT are left as they are. So
+	pins that the MCU drives itself (LCD bus, soft USART TX) can
+	be traced as well.
+	In TRACE_EDGE mode the whole port is read but only edges on
+	the INTx pin trigger a read, so put the line of interest on
+	INT0(PD2), INT1(PD3) or INT2(PB2).
+	In TRACE_EDGE mode a duration longer than 65536 ticks (32.7ms
+	@ 16Mhz) rolls over.
+	Runs longer than 65535 ticks are split in two entries.
+	With TRACE_STOP_WHEN_FULL as NO the ring keeps the latest
+	TRACE_DEPTH runs, else capture stops once the ring is full.
+----------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#undef YES
+#undef NO
+#define YES 1
+#define NO 2
+
+#define TRACE_SAMPLED 1
+#define TRACE_EDGE 2
+
+#define INTR0 1
+#define INTR1 2
+#define INTR2 3
+/*------------------------------------------------------*/
+
+
+
+/******************* USER CONFIGURABLE *******************/
+#define TRACE_MODE TRACE_SAMPLED	// options are TRACE_SAMPLED, TRACE_EDGE
+#define TRACE_PIN PINA			// port under watch. PINA, PINB, PINC, PIND
+#define TRACE_MASK 0xFF				// pins of the port to record
+#define TRACE_RATE 100000UL			// samples per second (TRACE_SAMPLED)
+#define TRACE_EDGE_INTR INTR0		// INTR0(PD2), INTR1(PD3), INTR2(PB2) (TRACE_EDGE)
+#define TRACE_DEPTH 128				// runs in the ring. 2, 4, 8 ... 256
+#define TRACE_STOP_WHEN_FULL NO
+/*-------------------------------------------------------*/
+
+
+
+/********************* DEPENDENCY *********************/
+#ifndef RCV_PKT_LEN
+	#include "../int/usart/usart.h"
+#endif
+
+#if TRACE_MODE == TRACE_SAMPLED
+	#ifndef T0_PRESCALER_NONE
+		#include "../int/timer0/timer0.h"
+	#endif
+#elif TRACE_MODE == TRACE_EDGE
+	#ifndef T1_PRESCALER_NONE
+		#include "../int/timer1/timer1.h"
+	#endif
+#endif
+
+#if (TRACE_DEPTH & (TRACE_DEPTH - 1)) || TRACE_DEPTH > 256
+	#error TRACE_DEPTH HAS TO BE A POWER OF TWO UPTO 256
+#endif
+/*----------------------------------------------------*/
+
+
+
+/******************* TIMER SETTINGS *******************/
+#if TRACE_MODE == TRACE_SAMPLED
+	#if (F_CPU / TRACE_RATE) <= 256
+		#define TRACE_PRESCALER T0_PRESCALER_1
+		#define TRACE_OCR ((F_CPU / TRACE_RATE) - 1)
+		#define TRACE_TICK_RATE (F_CPU / (TRACE_OCR + 1))
+	#elif (F_CPU / 8 / TRACE_RATE) <= 256
+		#define TRACE_PRESCALER T0_PRESCALER_8
+		#define TRACE_OCR ((F_CPU / 8 / TRACE_RATE) - 1)
+		#define TRACE_TICK_RATE (F_CPU / 8 / (TRACE_OCR + 1))
+	#elif (F_CPU / 64 / TRACE_RATE) <= 256
+		#define TRACE_PRESCALER T0_PRESCALER_64
+		#define TRACE_OCR ((F_CPU / 64 / TRACE_RATE) - 1)
+		#define TRACE_TICK_RATE (F_CPU / 64 / (TRACE_OCR + 1))
+	#else
+		#error TRACE_RATE IS TOO LOW
+	#endif
+#else
+	#define TRACE_TICK_RATE (F_CPU / 8)
+#endif
+/*----------------------------------------------------*/
+
+
+
+/*********************** GLOBAL ***********************/
+struct logicTrace {
+	uint8_t value;			// value of the run in progress
+	uint16_t run;			// samples of the run in progress (TRACE_SAMPLED)
+	uint16_t stamp;			// start of the run in progress (TRACE_EDGE)
+	uint8_t head;			// next free entry
+	volatile uint16_t count;	// entries held
+	volatile uint8_t isRunning;
+} trace;
+
+uint8_t traceValue[TRACE_DEPTH];
+uint16_t traceDuration[TRACE_DEPTH];
+/*----------------------------------------------------*/
+
+
+
+/********************** INTERNALS **********************/
+static inline void traceStore(uint8_t value, uint16_t duration) {
+	uint8_t h = trace.head;
+	#if TRACE_STOP_WHEN_FULL == YES
+		if(trace.count == TRACE_DEPTH) {
+			trace.isRunning = 0; // keep the first TRACE_DEPTH runs
+			return;
+		}
+	#endif
+	traceValue[h] = value;
+	traceDuration[h] = duration;
+	trace.head = (h + 1) & (TRACE_DEPTH - 1);
+	if(trace.count < TRACE_DEPTH) {
+		trace.count++;
+	}
+	#if TRACE_STOP_WHEN_FULL == YES
+		if(trace.count == TRACE_DEPTH) {
+			trace.isRunning = 0;
+		}
+	#endif
+}
+
+
+static inline void traceWrite16(uint16_t data) {
+	UWriteData(lByte(data));
+	UWriteData(hByte(data));
+}
+/*-----------------------------------------------------*/
+
+
+
+/******************* USER FUNCTIONS *******************/
+void traceInit() {
+	trace.isRunning = 0;
+	trace.count = 0;
+	trace.head = 0;
+
+	#if TRACE_MODE == TRACE_SAMPLED
+		T0ClockSelect(T0_PRESCALER_NONE);
+		T0operationMode(T0_OPMODE_CTC);
+		T0ocMode(T0_OC0_NORNAL);
+		OCR0 = TRACE_OCR;
+	#elif TRACE_MODE == TRACE_EDGE
+		T1freeRunStart();
+		#if TRACE_EDGE_INTR == INTR0
+			MCUCR &= ~(3<<ISC00);
+			MCUCR |= (1<<ISC00); // any logical change on INT0
+		#elif TRACE_EDGE_INTR == INTR1
+			MCUCR &= ~(3<<ISC10);
+			MCUCR |= (1<<ISC10); // any logical change on INT1
+		#endif
+	#endif
+}
+
+
+void traceStart() {
+	cli();
+	trace.count = 0;
+	trace.head = 0;
+	trace.value = TRACE_PIN & TRACE_MASK;
+	trace.run = 0;
+	trace.isRunning = 1;
+
+	#if TRACE_MODE == TRACE_SAMPLED
+		TCNT0 = 0;
+		clearOC0InterruptFlag();
+		enableOC0Interrupt();
+		T0ClockSelect(TRACE_PRESCALER);
+	#elif TRACE_MODE == TRACE_EDGE
+		trace.stamp = TCNT1;
+		#if TRACE_EDGE_INTR == INTR0
+			GIFR = (1<<INTF0);
+			GICR |= (1<<INT0);
+		#elif TRACE_EDGE_INTR == INTR1
+			GIFR = (1<<INTF1);
+			GICR |= (1<<INT1);
+		#elif TRACE_EDGE_INTR == INTR2
+			// INT2 knows only one edge at a time. Wait for the opposite one
+			GICR &= ~(1<<INT2); // ISC2 may only change with INT2 off
+			if(PINB & (1<<PB2)) {
+				MCUCSR &= ~(1<<ISC2);
+			}
+			else {
+				MCUCSR |= (1<<ISC2);
+			}
+			GIFR = (1<<INTF2);
+			GICR |= (1<<INT2);
+		#endif
+	#endif
+	sei();
+}
+
+
+void traceStop() {
+	cli();
+	#if TRACE_MODE == TRACE_SAMPLED
+		T0ClockSelect(T0_PRESCALER_NONE);
+		disableOC0Interrupt();
+		if(trace.isRunning && trace.run) {
+			traceStore(trace.value, trace.run);
+		}
+	#elif TRACE_MODE == TRACE_EDGE
+		#if TRACE_EDGE_INTR == INTR0
+			GICR &= ~(1<<INT0);
+		#elif TRACE_EDGE_INTR == INTR1
+			GICR &= ~(1<<INT1);
+		#elif TRACE_EDGE_INTR == INTR2
+			GICR &= ~(1<<INT2);
+		#endif
+		if(trace.isRunning) {
+			traceStore(trace.value, TCNT1 - trace.stamp);
+		}
+	#endif
+	trace.isRunning = 0;
+	sei();
+}
+
+
+#define traceRuns() (trace.count)
+
+
+// call after traceStop()
+void traceDump() {
+	uint16_t i;
+	uint8_t index = (trace.head - trace.count) & (TRACE_DEPTH - 1); // oldest
+
+	UWriteData('L');
+	UWriteData('A');
+	UWriteData(TRACE_MODE);
+	UWriteData(TRACE_MASK);
+	traceWrite16((uint16_t)TRACE_TICK_RATE);
+	traceWrite16((uint16_t)(TRACE_TICK_RATE>>16));
+	traceWrite16(trace.count);
+
+	for(i=0; i<trace.count; i++) {
+		UWriteData(traceValue[index]);
+		traceWrite16(traceDuration[index]);
+		index = (index + 1) & (TRACE_DEPTH - 1);
+	}
+}
+/*----------------------------------------------------*/
+
+
+
+/************************ ISR ************************/
+#if TRACE_MODE == TRACE_SAMPLED
+	#ifdef ISR_DISPATCH
+		#define ISR_CLAIM_TIMER0_COMP
+		#include "../int/isr/isrClaim.h"
+		SHARED_ISR
+	#else
+		ISR(TIMER0_COMP_vect)
+	#endif
+	{
+		uint8_t v = TRACE_PIN & TRACE_MASK;
+		uint16_t run = trace.run;
+
+		if(v == trace.value && run != 0xFFFF) {
+			trace.run = run + 1;
+			return;
+		}
+		traceStore(trace.value, run);
+		trace.value = v;
+		trace.run = 1;
+		#if TRACE_STOP_WHEN_FULL == YES
+			if(!trace.isRunning) {
+				T0ClockSelect(T0_PRESCALER_NONE);
+			}
+		#endif
+	}
+
+#elif TRACE_MODE == TRACE_EDGE
+	#if TRACE_EDGE_INTR == INTR0
+		#define ISR_CLAIM_INT0
+		#define TRACE_VECT INT0_vect
+	#elif TRACE_EDGE_INTR == INTR1
+		#define ISR_CLAIM_INT1
+		#define TRACE_VECT INT1_vect
+	#elif TRACE_EDGE_INTR == INTR2
+		#define ISR_CLAIM_INT2
+		#define TRACE_VECT INT2_vect
+	#endif
+
+	#ifdef ISR_DISPATCH
+		#include "../int/isr/isrClaim.h"
+		SHARED_ISR
+	#else
+		ISR(TRACE_VECT)
+	#endif
+	{
+		uint16_t now = TCNT1;
+		if(!trace.isRunning) {
+			return;
+		}
+		traceStore(trace.value, now - trace.stamp);
+		trace.stamp = now;
+		trace.value = TRACE_PIN & TRACE_MASK;
+		#if TRACE_EDGE_INTR == INTR2
+			GICR &= ~(1<<INT2); // ISC2 may only change with INT2 off
+			MCUCSR ^= (1<<ISC2); // wait for the other edge
+			GIFR = (1<<INTF2); // changing ISC2 can raise the flag
+			GICR |= (1<<INT2);
+		#endif
+	}
+#endif
+/*---------------------------------------------------*/
+
+
+
+/************************ UNDEFINE ************************/
+#undef INTR0
+#undef INTR1
+#undef INTR2
+/*--------------------------------------------------------*/
+
+
+
+/********************** EXAMPLE CODE **********************
+// records what the LCD bus (PORTC) does during LCDInit()
+// and sends it to the PC
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/io/logicTrace.h"
+#include "mega16/ext/lcd16x2/lcd.h"
+
+int main() {
+	USARTInit(115200);
+	traceInit();
+
+	traceStart();
+	LCDInit(LS_NONE);
+	traceStop();
+
+	traceDump();
+	while(1) {
+	}
+}
+
+// NOTE: in logicTrace.h set
+// #define TRACE_PIN PINC
+// #define TRACE_MASK 0xFC
+---------------------------------------------------------*/
@@ -0,0 +1,213 @@
+/******************** DESCRIPTION ********************
+Protothreads. Stackless threads in plain C, after the idea of
+Adam Dunkels. A protothread is a normal function that returns
+while it waits for something and continues from the same line
+on the next call. Only the line number is kept (2 bytes per
+thread), so any number of them fit in the SRAM of a mega16.
+
+The main loop calls every thread one after another. A thread
+that waits on hardware (LCD busy flag, EEPROM write cycle, echo
+pin ...) returns at once, so the others keep going in between.
+
+	uint8_t blinker(struct pt *pt) {
+		static struct ptTimer t;	// locals do not survive a wait
+		PT_BEGIN(pt);
+		while(1) {
+			outHigh(A7);
+			PT_WAIT_US(pt, &t, 500000);
+			outLow(A7);
+			PT_WAIT_US(pt, &t, 500000);
+		}
+		PT_END(pt);
+	}
+
+MACROS:
+	1. PT_INIT(&pt); 				=> thread starts from the top on next call
+	2. PT_BEGIN(&pt); PT_END(&pt);	=> first and last line of a thread
+	3. PT_WAIT_UNTIL(&pt, cond); 	=> returns until cond is true
+	4. PT_WAIT_WHILE(&pt, cond); 	=> returns while cond is true
+	5. PT_YIELD(&pt); 				=> gives the others one turn
+	6. PT_SPAWN(&pt, &child, call);	=> runs a child thread to its end
+	7. PT_WAIT_US(&pt, &timer, us);	=> waits for so many micro seconds
+	8. PT_EXIT(&pt); 				=> ends the thread early
+	9. PT_SCHEDULE(call); 			=> non zero while the thread is alive
+
+TIMERS:
+	ptClock() is TCNT1 with Timer1 free running at F_CPU/8 (0.5us
+	per tick @ 16Mhz), started by ptInit(). A ptTimer collects
+	the ticks that went by at every check, so waits longer than
+	one Timer1 round (65536 ticks, 32.7ms @ 16Mhz) work as long
+	as the thread gets a turn at least once every round.
+
+NOTE:
+	Local variables of a thread are lost at every wait. Keep
+	them static or in a struct handed to the thread.
+	A "switch" can not be used inside a thread across a wait,
+	the thread itself is one big switch.
+	Timer1 can not be used for PWM, CTC (T1Stepper.h) at the
+	same time. T1Servo.h and logicTrace.h share the free running
+	mode and are fine.
+----------------------------------------------------*/
+
+
+
+/*********************** DEPENDENCY ***********************/
+#ifndef T1_PRESCALER_NONE
+	#include "../int/timer1/timer1.h"
+#endif
+/*--------------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#define PT_WAITING 0
+#define PT_YIELDED 1
+#define PT_EXITED 2
+#define PT_ENDED 3
+/*------------------------------------------------------*/
+
+
+
+/************************* GLOBAL *************************/
+struct pt {
+	uint16_t lc; // line to continue from
+};
+
+struct ptTimer {
+	uint16_t last;	// clock at the previous check
+	uint32_t left;	// ticks still to go
+};
+/*--------------------------------------------------------*/
+
+
+
+/************************* MACROS *************************/
+#define PT_INIT(pt) ((pt)->lc = 0)
+
+#define PT_BEGIN(pt) switch((pt)->lc) { case 0:
+
+#define PT_END(pt) } (pt)->lc = 0; return PT_ENDED
+
+#define PT_WAIT_UNTIL(pt, cond) \
+	do { \
+		(pt)->lc = __LINE__; case __LINE__: \
+		if(!(cond)) { \
+			return PT_WAITING; \
+		} \
+	} while(0)
+
+#define PT_WAIT_WHILE(pt, cond) PT_WAIT_UNTIL((pt), !(cond))
+
+#define PT_YIELD(pt) \
+	do { \
+		(pt)->lc = __LINE__; \
+		return PT_YIELDED; \
+		case __LINE__: ; \
+	} while(0)
+
+#define PT_EXIT(pt) \
+	do { \
+		PT_INIT(pt); \
+		return PT_EXITED; \
+	} while(0)
+
+#define PT_SCHEDULE(call) ((call) < PT_EXITED)
+
+#define PT_SPAWN(pt, child, call) \
+	do { \
+		PT_INIT(child); \
+		PT_WAIT_UNTIL((pt), !PT_SCHEDULE(call)); \
+	} while(0)
+
+#define PT_WAIT_US(pt, timer, us) \
+	do { \
+		ptTimerSet((timer), (us)); \
+		PT_WAIT_UNTIL((pt), ptTimerExpired(timer)); \
+	} while(0)
+/*--------------------------------------------------------*/
+
+
+
+/******************* USER FUNCTIONS *******************/
+void ptInit() {
+	cli();
+	T1freeRunStart();
+	sei();
+}
+
+
+// 16 bit read of TCNT1 goes through the TEMP register,
+// which an ISR touching Timer1 would spoil half way
+static inline uint16_t ptClock() {
+	uint8_t sreg = SREG;
+	uint16_t now;
+	cli();
+	now = TCNT1;
+	SREG = sreg;
+	return now;
+}
+
+
+void ptTimerSet(struct ptTimer *t, uint32_t us) {
+	t->last = ptClock();
+	t->left = T1_US_TICKS(us);
+}
+
+
+uint8_t ptTimerExpired(struct ptTimer *t) {
+	uint16_t now = ptClock();
+	uint16_t gone = now - t->last; // unsigned, so a roll over is fine
+	t->last = now;
+	if(gone >= t->left) {
+		t->left = 0;
+		return 1;
+	}
+	t->left -= gone;
+	return 0;
+}
+/*-----------------------------------------------------*/
+
+
+
+/******************* EXAMPLE CODE *******************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/io/gpio.h"
+#include "mega16/io/pt.h"
+
+struct pt ptA, ptB;
+
+// two leds blinking at rates that do not divide each other
+uint8_t blinkA(struct pt *pt) {
+	static struct ptTimer t;
+	PT_BEGIN(pt);
+	while(1) {
+		PORTA ^= (1<<PA6);
+		PT_WAIT_US(pt, &t, 300000);
+	}
+	PT_END(pt);
+}
+
+uint8_t blinkB(struct pt *pt) {
+	static struct ptTimer t;
+	PT_BEGIN(pt);
+	while(1) {
+		PORTA ^= (1<<PA7);
+		PT_WAIT_US(pt, &t, 700000);
+	}
+	PT_END(pt);
+}
+
+int main() {
+	DDRA |= (1<<PA6) | (1<<PA7);
+	ptInit();
+	PT_INIT(&ptA);
+	PT_INIT(&ptB);
+
+	while(1) {
+		blinkA(&ptA);
+		blinkB(&ptB);
+	}
+}
+-----------------------------------------------------*/
@@ -0,0 +1,485 @@
+/******************** DESCRIPTION ********************
+Resumable versions of the drivers that keep the CPU waiting.
+They are protothreads (see pt.h): each call does as much as it
+can without waiting and returns. Call it again and again (from
+the main loop) until it returns PT_ENDED, then the job is done.
+Several of them, on different devices, run side by side.
+
+	blocking			resumable					waits on
+	LCDByte()			ptLCDByte()					busy flag
+	LCDWriteStringXY()	ptLCDWriteStringXY()		busy flag, per char
+	EEWriteByte()		ptEEWriteByte()				12ms write cycle
+	EEWritePage()		ptEEWritePage()				12ms write cycle
+	USgetRange()		ptUSgetRange()				echo pin, 10ms rest
+	CSgetColor()		ptCSgetColor()				yields between colours
+	softUSARTWrite()	ptSoftUSARTWrite()			every bit time
+
+Every job keeps its state in its own small struct (ptLCD,
+ptEEPROM ...), one per device. The arguments are taken at the
+first call of a job, the later calls may pass the same ones.
+
+	struct ptLCD lcdJob;
+	PT_INIT(&lcdJob.pt);
+	while(PT_SCHEDULE(ptLCDWriteStringXY(&lcdJob,0,0,"Hello"))) {
+		// other work here
+	}
+
+NOTE:
+	ptInit() (pt.h) has to be called once, it starts the Timer1
+	clock the waits are measured with.
+	Only the drivers made YES below are compiled in. Their own
+	headers are included from here.
+	ptLCDWriteStringXY() does not handle the "%0".."%7" custom
+	character escapes of LCDWriteString().
+	ptUSgetRange() times the echo with Timer1 while polling, so
+	range is in F_CPU/8 ticks, 0.5us @ 16Mhz (as USgetRange()),
+	but only as fine as the time one round of the main loop takes.
+	ptSoftUSARTWrite() flips the pin at the first call after
+	each bit time. One round of the main loop has to be well
+	below a bit (416us at 2400) or the bytes get garbled, so do
+	not pair it with ptCSgetColor(), which still blocks for one
+	period of the sensor output.
+----------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#undef YES
+#undef NO
+#define YES 1
+#define NO 2
+/*------------------------------------------------------*/
+
+
+
+/******************* USER CONFIGURABLE *******************/
+#define PT_LCD YES
+#define PT_EEPROM NO
+#define PT_ULTRASONIC NO
+#define PT_COLOR_SENSOR NO
+#define PT_SOFT_USART NO
+
+#define PT_US_TIMEOUT_US 40000UL	// HC-SR04 gives up after 38ms
+/*-------------------------------------------------------*/
+
+
+
+/********************* DEPENDENCY *********************/
+#ifndef PT_WAITING
+	#include "pt.h"
+#endif
+
+#ifndef GPIO
+	#include "gpio.h"
+#endif
+
+#if PT_LCD == YES
+	#ifndef _LCD_H
+		#include "../ext/lcd16x2/lcd.h"
+	#endif
+#endif
+
+#if PT_EEPROM == YES
+	#ifndef EXT_EEPROM
+		#include "../ext/eeprom/eeprom.h"
+	#endif
+#endif
+
+#if PT_ULTRASONIC == YES
+	#ifndef HCSR04
+		#include "../ext/ultrasonic/hcsr04.h"
+	#endif
+#endif
+
+#if PT_COLOR_SENSOR == YES
+	#ifndef TSC3200
+		#include "../ext/coloSensor/TSC3200.h"
+	#endif
+#endif
+
+#if PT_SOFT_USART == YES
+	#ifndef BAUD_DELAY
+		#include "../softUSART/softUSART.h"
+	#endif
+#endif
+/*----------------------------------------------------*/
+
+
+
+/************************* GLOBAL *************************/
+struct ptLCD {
+	struct pt pt;
+	const char *msg;
+};
+
+struct ptEEPROM {
+	struct pt pt;
+	struct ptTimer timer;
+	uint8_t ok;		// 1 once the job ended well
+};
+
+struct ptUltrasound {
+	struct pt pt;
+	struct ptTimer timer;
+};
+
+struct ptColorSensor {
+	struct pt pt;
+	uint8_t colour;	// 0 green, 1 blue, 2 clear, 3 red
+};
+
+struct ptSoftUsart {
+	struct pt pt;
+	uint16_t due;	// clock at which the next bit starts
+	uint8_t frac;	// 1/256 of a tick on top of due
+	uint8_t byte;
+	uint8_t bit;
+};
+/*--------------------------------------------------------*/
+
+
+
+/*********************** LCD ***********************/
+#if PT_LCD == YES
+// one read of the status register, same bus cycle as
+// LCDBusyLoop() but without looping
+uint8_t ptLCDBusy() {
+	uint8_t status;
+
+	LCD_DATA_DDR &= ~(0x0F<<LCD_DATA_POS);
+	SET_RW();
+	CLEAR_RS();
+	_delay_us(0.5);
+
+	SET_E();
+	_delay_us(0.5);
+	status = (uint8_t)(LCD_DATA_PIN>>LCD_DATA_POS) << 4;
+	_delay_us(0.5);
+	CLEAR_E();
+	_delay_us(1);
+
+	SET_E();
+	_delay_us(0.5);
+	status |= (LCD_DATA_PIN>>LCD_DATA_POS) & 0x0F;
+	_delay_us(0.5);
+	CLEAR_E();
+	_delay_us(1);
+
+	CLEAR_RW();
+	LCD_DATA_DDR |= (0x0F<<LCD_DATA_POS);
+	return status & 0x80;
+}
+
+
+// LCDByte() without the busy loop at the end
+void ptLCDSend(uint8_t c, uint8_t isData) {
+	if(isData) {
+		SET_RS();
+	}
+	else {
+		CLEAR_RS();
+	}
+	_delay_us(0.5);
+
+	SET_E();
+	LCD_DATA_PORT = (LCD_DATA_PORT & ~(0x0F<<LCD_DATA_POS)) | ((c>>4)<<LCD_DATA_POS);
+	_delay_us(1);
+	CLEAR_E();
+	_delay_us(1);
+
+	SET_E();
+	LCD_DATA_PORT = (LCD_DATA_PORT & ~(0x0F<<LCD_DATA_POS)) | ((c & 0x0F)<<LCD_DATA_POS);
+	_delay_us(1);
+	CLEAR_E();
+	_delay_us(1);
+}
+
+
+// DDRAM address command of LCDGotoXY()
+uint8_t ptLCDAddress(uint8_t x, uint8_t y) {
+	#ifdef LCD_TYPE_164
+		static const uint8_t rowStart[4] = {0x00, 0x40, 0x10, 0x50};
+	#else
+		static const uint8_t rowStart[4] = {0x00, 0x40, 0x14, 0x54};
+	#endif
+	return 0x80 | (x + rowStart[y & 3]);
+}
+
+
+// waits till the LCD is free, then sends one command or data byte
+uint8_t ptLCDByte(struct ptLCD *lcd, uint8_t c, uint8_t isData) {
+	PT_BEGIN(&lcd->pt);
+	PT_WAIT_WHILE(&lcd->pt, ptLCDBusy());
+	ptLCDSend(c, isData);
+	PT_END(&lcd->pt);
+}
+
+
+uint8_t ptLCDWriteStringXY(struct ptLCD *lcd, uint8_t x, uint8_t y, const char *msg) {
+	PT_BEGIN(&lcd->pt);
+	lcd->msg = msg;
+	PT_WAIT_WHILE(&lcd->pt, ptLCDBusy());
+	ptLCDSend(ptLCDAddress(x, y), 0);
+
+	while(*lcd->msg) {
+		PT_WAIT_WHILE(&lcd->pt, ptLCDBusy());
+		ptLCDSend(*lcd->msg, 1);
+		lcd->msg++;
+	}
+	PT_END(&lcd->pt);
+}
+#endif
+/*--------------------------------------------------*/
+
+
+
+/********************** EEPROM **********************/
+#if PT_EEPROM == YES
+uint8_t ptEEWriteByte(struct ptEEPROM *ee, uint8_t devAddress, uint16_t memAddress, uint8_t data) {
+	PT_BEGIN(&ee->pt);
+	ee->ok = 0;
+
+	// the bus part takes less than 0.5ms at 100 Khz
+	if(!TWI_START())
+		PT_EXIT(&ee->pt);
+	if(!TWI_SLA_W(devAddress))
+		PT_EXIT(&ee->pt);
+	if(!TWI_ByteWrite(memAddress>>8))
+		PT_EXIT(&ee->pt);
+	if(!TWI_ByteWrite(memAddress))
+		PT_EXIT(&ee->pt);
+	if(!TWI_ByteWrite(data))
+		PT_EXIT(&ee->pt);
+	TWI_STOP();
+
+	// internal write cycle
+	PT_WAIT_US(&ee->pt, &ee->timer, 12000UL);
+	ee->ok = 1;
+	PT_END(&ee->pt);
+}
+
+
+// writes the 32 bytes of seqWrite[] as EEWritePage() does
+uint8_t ptEEWritePage(struct ptEEPROM *ee, uint8_t devAddress, uint16_t pageAddress) {
+	uint16_t memAddress = pageAddress<<5;
+	uint8_t i;
+
+	PT_BEGIN(&ee->pt);
+	ee->ok = 0;
+
+	if(!TWI_START())
+		PT_EXIT(&ee->pt);
+	if(!TWI_SLA_W(devAddress))
+		PT_EXIT(&ee->pt);
+	if(!TWI_ByteWrite(memAddress>>8))
+		PT_EXIT(&ee->pt);
+	if(!TWI_ByteWrite(memAddress))
+		PT_EXIT(&ee->pt);
+	for(i=0; i<32; i++) {
+		if(!TWI_ByteWrite(seqWrite[i]))
+			PT_EXIT(&ee->pt);
+	}
+	TWI_STOP();
+
+	PT_WAIT_US(&ee->pt, &ee->timer, 12000UL);
+	ee->ok = 1;
+	PT_END(&ee->pt);
+}
+#endif
+/*--------------------------------------------------*/
+
+
+
+/******************** ULTRASONIC ********************/
+#if PT_ULTRASONIC == YES
+// range in F_CPU/8 ticks like USgetRange(). 0xFFFF if no echo came back
+uint8_t ptUSgetRange(struct ptUltrasound *u, struct ultrasound *us) {
+	PT_BEGIN(&u->pt);
+	if(us->power) {
+		outLow(us->power); // active low transistor switch
+	}
+
+	outHigh(us->trig);
+	_delay_us(10);
+	outLow(us->trig);
+
+	ptTimerSet(&u->timer, PT_US_TIMEOUT_US);
+	PT_WAIT_UNTIL(&u->pt, getInput(us->echo) || ptTimerExpired(&u->timer));
+	us->range = 0xFFFF;
+
+	if(u->timer.left) {
+		// rising edge. the timer now counts the echo
+		ptTimerSet(&u->timer, PT_US_TIMEOUT_US);
+		PT_WAIT_UNTIL(&u->pt, !getInput(us->echo) || ptTimerExpired(&u->timer));
+		if(u->timer.left) {
+			uint32_t ticks = T1_US_TICKS(PT_US_TIMEOUT_US) - u->timer.left;
+			us->range = (ticks > 0xFFFF) ? 0xFFFF : ticks;
+		}
+	}
+
+	if(us->power) {
+		outHigh(us->power);
+	}
+	PT_WAIT_US(&u->pt, &u->timer, 10000UL); // inter poll delay
+	PT_END(&u->pt);
+}
+#endif
+/*--------------------------------------------------*/
+
+
+
+/******************* COLOR SENSOR *******************/
+#if PT_COLOR_SENSOR == YES
+uint8_t ptCSgetColor(struct ptColorSensor *c, struct colorSensor *cs) {
+	uint32_t freq;
+	uint8_t value;
+
+	PT_BEGIN(&c->pt);
+	if(cs->power) {
+		outLow(cs->power);
+	}
+
+	for(c->colour=0; c->colour<4; c->colour++) {
+		// s2:s3 => green 1:1, blue 0:1, clear 1:0, red 0:0
+		if(c->colour & 1) {
+			outLow(cs->s2);
+		}
+		else {
+			outHigh(cs->s2);
+		}
+		if(c->colour < 2) {
+			outHigh(cs->s3);
+		}
+		else {
+			outLow(cs->s3);
+		}
+
+		PT_YIELD(&c->pt); // others run while the filter switches
+
+		freq = getT0Freq(cs->vOut);
+		value = (freq > 51000) ? 255 : freq/200; // saturation
+		if(c->colour == 0) {
+			cs->green = value;
+		}
+		else if(c->colour == 1) {
+			cs->blue = value;
+		}
+		else if(c->colour == 2) {
+			cs->clear = value;
+		}
+		else {
+			cs->red = value;
+		}
+	}
+
+	if(cs->power) {
+		outHigh(cs->power);
+	}
+	PT_END(&c->pt);
+}
+#endif
+/*--------------------------------------------------*/
+
+
+
+/******************** SOFT USART ********************/
+#if PT_SOFT_USART == YES
+// next bit edge at the baud of usart, with the 1/256 tick
+// fraction carried (see softUSART.h)
+static inline void ptSoftBitNext(struct ptSoftUsart *s, struct softUsart *usart) {
+	uint8_t f = s->frac;
+	s->frac = f + usart->bitFrac;
+	s->due += usart->bitTicks;
+	if(s->frac < f) {
+		s->due++;
+	}
+}
+
+
+// bit edges are kept on a fixed grid from the start bit, so a
+// late turn delays one edge but does not stretch the frame
+uint8_t ptSoftUSARTWrite(struct ptSoftUsart *s, struct softUsart *usart, uint8_t byte) {
+	PT_BEGIN(&s->pt);
+	s->byte = byte;
+	s->due = ptClock();
+	s->frac = 0;
+	outLow(usart->tx); // start bit
+
+	// 8 data bits LSB first, then the stop bit
+	for(s->bit=0; s->bit<9; s->bit++) {
+		ptSoftBitNext(s, usart);
+		PT_WAIT_UNTIL(&s->pt, (int16_t)(ptClock() - s->due) >= 0);
+		if(s->bit == 8 || (s->byte & 1)) {
+			outHigh(usart->tx);
+		}
+		else {
+			outLow(usart->tx);
+		}
+		s->byte >>= 1;
+	}
+
+	// let the stop bit run its full length
+	ptSoftBitNext(s, usart);
+	PT_WAIT_UNTIL(&s->pt, (int16_t)(ptClock() - s->due) >= 0);
+	PT_END(&s->pt);
+}
+#endif
+/*--------------------------------------------------*/
+
+
+
+/******************* EXAMPLE CODE *******************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/io/gpio.h"
+#include "mega16/io/ptDrivers.h" // PT_LCD, PT_EEPROM, PT_ULTRASONIC are YES
+
+struct ultrasound us0;
+
+struct ptLCD lcdJob;
+struct ptEEPROM eeJob;
+struct ptUltrasound usJob;
+
+struct pt mainPt;
+char text[6];
+
+// measures, shows and logs the range, all three at the same time
+uint8_t app(struct pt *pt) {
+	static uint16_t address;
+	static uint8_t lcdOn, eeOn;
+	PT_BEGIN(pt);
+	while(1) {
+		PT_SPAWN(pt, &usJob.pt, ptUSgetRange(&usJob, &us0));
+		utoa(us0.range, text, 10);
+		PT_INIT(&lcdJob.pt);
+		PT_INIT(&eeJob.pt);
+		lcdOn = 1;
+		eeOn = 1;
+		// LCD and EEPROM make progress together. A job that has
+		// ended is not called again, it would start over
+		PT_WAIT_UNTIL(pt,
+			((lcdOn = lcdOn && PT_SCHEDULE(ptLCDWriteStringXY(&lcdJob,0,0,text))) |
+			 (eeOn = eeOn && PT_SCHEDULE(ptEEWriteByte(&eeJob,80,address,us0.range>>8)))) == 0);
+		address++;
+	}
+	PT_END(pt);
+}
+
+int main() {
+	initGPIO();
+	LCDInit(LS_NONE);
+	LCDClear();
+	initTWI(0,5);
+	ptInit();
+
+	us0.echo = D6;
+	us0.trig = A0;
+	us0.power = 0;
+
+	PT_INIT(&mainPt);
+	while(1) {
+		app(&mainPt);
+	}
+}
+-----------------------------------------------------*/
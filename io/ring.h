@@ -0,0 +1,167 @@
+/******************** DESCRIPTION ********************
+Ring buffer to pass data from an ISR to the main loop (or the
+other way round) without losing it when the reader is late.
+One side only writes (producer), the other only reads
+(consumer). Both sides work without cli(): each index is one
+byte, which the AVR reads and writes in one go, and each index
+is changed by one side only.
+
+RING_TYPE(name, type, size) makes a ring type for elements of
+"type" and the functions that work on it:
+
+	RING_TYPE(byteRing, uint8_t, 16)	// once, at file level
+	struct byteRing rx;					// as many as needed
+
+FUNCTIONS (name is the first argument of RING_TYPE):
+	1. nameInit(&r); 				=> empties the ring
+	2. namePush(&r, v); 			=> adds v. 0 if full
+	3. namePop(&r, &v); 			=> takes the oldest. 0 if empty
+	4. nameCount(&r); 				=> elements waiting
+	5. nameFree(&r); 				=> elements that still fit
+	6. namePushBlock(&r, src, n);	=> adds upto n, returns how many
+	7. namePopBlock(&r, dst, n); 	=> takes upto n, returns how many
+	8. nameFlush(&r); 				=> drops all waiting (consumer side)
+
+NOTE:
+	size must be a power of 2 upto 128. The indices run free
+	from 0 to 255 and are masked at use, so all "size" slots
+	are usable.
+	Push, PushBlock belong to the producer. Pop, PopBlock and
+	Flush to the consumer. Init only before the ISR is on.
+	Block functions move the index once at the end, so the
+	other side sees the whole block at the same time.
+----------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+// keeps the compiler from moving the element copy across the
+// index read or update
+#define RING_BARRIER() __asm__ __volatile__("" ::: "memory")
+
+// a size that is not a power of 2 upto 128 fails to compile with
+// "size of array is negative"
+#define RING_CHECK_SIZE(name, size) \
+	typedef char name##SizeCheck[(((size) & ((size) - 1)) == 0 && (size) <= 128) ? 1 : -1]
+/*------------------------------------------------------*/
+
+
+
+/************************* MACROS *************************/
+#define RING_TYPE(name, type, size) \
+	RING_CHECK_SIZE(name, size); \
+	struct name { \
+		volatile uint8_t head;	/* written by the producer */ \
+		volatile uint8_t tail;	/* written by the consumer */ \
+		type buf[size]; \
+	}; \
+	\
+	static inline void name##Init(struct name *r) { \
+		r->head = 0; \
+		r->tail = 0; \
+	} \
+	\
+	static inline uint8_t name##Count(struct name *r) { \
+		return (uint8_t)(r->head - r->tail); \
+	} \
+	\
+	static inline uint8_t name##Free(struct name *r) { \
+		return (size) - (uint8_t)(r->head - r->tail); \
+	} \
+	\
+	static inline uint8_t name##Push(struct name *r, type v) { \
+		uint8_t head = r->head; \
+		if((uint8_t)(head - r->tail) == (size)) { \
+			return 0; \
+		} \
+		r->buf[head & ((size) - 1)] = v; \
+		RING_BARRIER(); \
+		r->head = head + 1; \
+		return 1; \
+	} \
+	\
+	static inline uint8_t name##Pop(struct name *r, type *v) { \
+		uint8_t tail = r->tail; \
+		if(tail == r->head) { \
+			return 0; \
+		} \
+		RING_BARRIER(); /* no element read before head */ \
+		*v = r->buf[tail & ((size) - 1)]; \
+		RING_BARRIER(); \
+		r->tail = tail + 1; \
+		return 1; \
+	} \
+	\
+	static inline uint8_t name##PushBlock(struct name *r, const type *src, uint8_t n) { \
+		uint8_t head = r->head; \
+		uint8_t room = (size) - (uint8_t)(head - r->tail); \
+		uint8_t i; \
+		if(n > room) { \
+			n = room; \
+		} \
+		for(i=0; i<n; i++) { \
+			r->buf[(uint8_t)(head + i) & ((size) - 1)] = src[i]; \
+		} \
+		RING_BARRIER(); \
+		r->head = head + n; \
+		return n; \
+	} \
+	\
+	static inline uint8_t name##PopBlock(struct name *r, type *dst, uint8_t n) { \
+		uint8_t tail = r->tail; \
+		uint8_t count = (uint8_t)(r->head - tail); \
+		uint8_t i; \
+		if(n > count) { \
+			n = count; \
+		} \
+		RING_BARRIER(); \
+		for(i=0; i<n; i++) { \
+			dst[i] = r->buf[(uint8_t)(tail + i) & ((size) - 1)]; \
+		} \
+		RING_BARRIER(); \
+		r->tail = tail + n; \
+		return n; \
+	} \
+	\
+	static inline void name##Flush(struct name *r) { \
+		r->tail = r->head; \
+	}
+/*--------------------------------------------------------*/
+
+
+
+/******************* EXAMPLE CODE *******************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/io/ring.h"
+
+// INT0 counts presses, the main loop blinks once per press
+// even when it is busy while the presses come
+RING_TYPE(pressRing, uint16_t, 8)
+struct pressRing presses;
+volatile uint16_t pressNo;
+
+ISR(INT0_vect) {
+	pressRingPush(&presses, ++pressNo); // full => press is dropped
+}
+
+int main() {
+	uint16_t no;
+	DDRA |= (1<<PA7);
+	PORTD |= (1<<PD2);
+	pressRingInit(&presses);
+	MCUCR |= (1<<ISC01);	// falling edge
+	GICR |= (1<<INT0);
+	sei();
+
+	while(1) {
+		while(pressRingPop(&presses, &no)) {
+			PORTA |= (1<<PA7);
+			_delay_ms(200);
+			PORTA &= ~(1<<PA7);
+			_delay_ms(200);
+		}
+	}
+}
+-----------------------------------------------------*/
@@ -44,6 +44,10 @@ Resources:
 	#include "gpio.h"
 #endif
 
+#ifndef ISR_PROF_SLOTS
+	#include "../int/isr/isrProfile.h"
+#endif
+
 struct timekeeper {
 	volatile uint16_t us;
 	volatile uint16_t ms;
@@ -280,16 +284,27 @@ void InitTimeKeeper() {
 	
 #if TIMER == 2
 	#define TIMER_COMP_VECT_NAME TIMER2_COMP_vect
+	#define ISR_CLAIM_TIMER2_COMP
 #elif TIMER == 1
 	#if OCR_REG == A
 		#define TIMER_COMP_VECT_NAME TIMER1_COMPA_vect
+		#define ISR_CLAIM_TIMER1_COMPA
 	#elif OCR_REG == B
 		#define TIMER_COMP_VECT_NAME TIMER1_COMPB_vect
+		#define ISR_CLAIM_TIMER1_COMPB
 	#endif
 #elif TIMER == 0
 	#define TIMER_COMP_VECT_NAME TIMER0_COMP_vect
+	#define ISR_CLAIM_TIMER0_COMP
 #endif   
-ISR(TIMER_COMP_VECT_NAME){
+#ifdef ISR_DISPATCH
+	#include "../int/isr/isrClaim.h"
+	SHARED_ISR
+#else
+	ISR(TIMER_COMP_VECT_NAME)
+#endif
+{
+	ISR_PROF_ENTER(ISR_PROF_TIMEKEEPER);
     #if TIME_BASE == HUNDRED_US
 	    timeKeeper.us += 100;
 	    if(timeKeeper.us == 1000) {
@@ -362,4 +377,5 @@ ISR(TIMER_COMP_VECT_NAME){
 	    }
 	#endif
 
+	ISR_PROF_EXIT(ISR_PROF_TIMEKEEPER);
 }
@@ -0,0 +1,624 @@
+/******************** DESCRIPTION ********************
+A tiny preemptive kernel for mega16/32. Every task gets its own
+stack and runs as if it had the CPU alone. Timer0 ticks at
+KERNEL_TICK_HZ (1 Khz by default). At every tick all 32
+registers and SREG of the running task are pushed onto its own
+stack, the stack pointer is stored in its task block and the
+stack of the next task is switched in.
+
+The ready task of the highest priority always runs. Tasks of
+the same priority take turns, one tick each. A task gives up
+the CPU when it waits (kernelDelay, an empty semaphore, an empty
+or full queue). When a task wakes up a task of higher priority
+the switch happens at once. When an ISR does it, the switch
+happens at the next tick (within 1ms).
+
+A built in idle task (priority 0) runs when nobody else can.
+
+USER FUNCTIONS:
+	1. kernelTaskCreate(&t, func, arg, prio, stack, sizeof(stack));
+	2. kernelStart(); 				=> starts the tick, never returns
+	3. kernelDelay(ticks); 			=> task sleeps for so many ticks
+	4. kernelYield(); 				=> next task of same priority
+	5. kernelTicks(); 				=> ticks since kernelStart()
+	6. kernelStackFree(&t); 		=> bytes of the stack never used so far
+
+	7. kernelSemInit(&s, count);
+	8. kernelSemTake(&s); 			=> waits while count is 0
+	9. kernelSemGive(&s);
+	10. kernelSemGiveISR(&s); 		=> same from inside an ISR
+
+	11. kernelQueueInit(&q, buffer, sizeof(buffer));
+	12. kernelQueueSend(&q, byte); 	=> waits while full
+	13. kernelQueueReceive(&q); 	=> waits while empty
+	14. kernelQueueSendISR(&q, b); 	=> 0 if full, never waits
+	15. kernelQueueReceiveISR(&q, &b); => 0 if empty, never waits
+
+	A task is "void task(void *arg)" and must never return.
+	Task priorities start at 1, 0 belongs to the idle task.
+	Stacks are plain arrays: "uint8_t stackA[96];"
+
+MEASUREMENTS:
+	kernelStackFree(&t) gives the high water mark. Stacks are
+	filled with 0xA5 at create and the untouched bytes are
+	counted from the bottom.
+	With KERNEL_MEASURE YES every tick is timed with Timer1 free
+	running at F_CPU/8: kernel.tickCycles (last) and
+	kernel.tickCyclesMax in CPU cycles, including the register
+	save and restore. kernelOverhead() gives it in per mille of
+	the CPU time. 2% (20 per mille) is 320 cycles per 1ms tick @ 16Mhz.
+
+NOTE:
+	Timer0 is used up by the tick. The tick ISR is naked, so it
+	can not be shared through isrDispatch.h.
+	Every task stack needs 35 bytes for the saved context plus
+	what its own calls and the ISRs that may hit it use. 64
+	bytes is a sane minimum, check with kernelStackFree().
+	ISRs run on the stack of whichever task they interrupt.
+	The ISR variants must only be called with interrupts off,
+	which they are inside a normal ISR.
+----------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#undef YES
+#undef NO
+#define YES 1
+#define NO 2
+/*------------------------------------------------------*/
+
+
+
+/******************* USER CONFIGURABLE *******************/
+#define KERNEL_TICK_HZ 1000UL
+#define KERNEL_MAX_TASKS 4			// not counting the idle task
+#define KERNEL_IDLE_STACK 64
+#define KERNEL_IDLE_SLEEP YES		// idle task puts the CPU to SLEEP_MODE_IDLE
+#define KERNEL_MEASURE NO			// YES uses Timer1 to time every tick
+/*-------------------------------------------------------*/
+
+
+
+/********************* DEPENDENCY *********************/
+#include <avr/sleep.h>
+
+#ifndef T0_PRESCALER_NONE
+	#include "../int/timer0/timer0.h"
+#endif
+
+#if KERNEL_MEASURE == YES
+	#ifndef T1_PRESCALER_NONE
+		#include "../int/timer1/timer1.h"
+	#endif
+#endif
+/*----------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#define KERNEL_READY 0
+#define KERNEL_DELAYED 1
+#define KERNEL_BLOCKED 2
+
+#define KERNEL_STACK_FILL 0xA5
+#define KERNEL_OCR ((F_CPU/64/KERNEL_TICK_HZ) - 1)
+
+#if KERNEL_OCR > 255
+	#error KERNEL_TICK_HZ TOO LOW FOR TIMER0 WITH PRESCALER 64
+#endif
+
+// cycles spent outside the timed part of a tick: vector jump,
+// ISR call, register save, register restore, ret and reti
+#define KERNEL_CTX_CYCLES 175
+
+#define kernelCritical() uint8_t kernelSreg = SREG; cli()
+#define kernelCriticalEnd() (SREG = kernelSreg)
+
+// pushes r0, SREG, r1..r31 and stores SP in the running task
+#define KERNEL_SAVE_CONTEXT() __asm__ __volatile__ ( \
+	"push r0 \n\t" \
+	"in r0, __SREG__ \n\t" \
+	"cli \n\t" \
+	"push r0 \n\t" \
+	"push r1 \n\t" \
+	"clr r1 \n\t" \
+	"push r2 \n\t" "push r3 \n\t" "push r4 \n\t" "push r5 \n\t" \
+	"push r6 \n\t" "push r7 \n\t" "push r8 \n\t" "push r9 \n\t" \
+	"push r10 \n\t" "push r11 \n\t" "push r12 \n\t" "push r13 \n\t" \
+	"push r14 \n\t" "push r15 \n\t" "push r16 \n\t" "push r17 \n\t" \
+	"push r18 \n\t" "push r19 \n\t" "push r20 \n\t" "push r21 \n\t" \
+	"push r22 \n\t" "push r23 \n\t" "push r24 \n\t" "push r25 \n\t" \
+	"push r26 \n\t" "push r27 \n\t" "push r28 \n\t" "push r29 \n\t" \
+	"push r30 \n\t" "push r31 \n\t" \
+	"lds r26, kernelCurrent \n\t" \
+	"lds r27, kernelCurrent + 1 \n\t" \
+	"in r0, __SP_L__ \n\t" \
+	"st x+, r0 \n\t" \
+	"in r0, __SP_H__ \n\t" \
+	"st x+, r0 \n\t" \
+)
+
+// takes SP of the running task and pops in reverse order
+#define KERNEL_RESTORE_CONTEXT() __asm__ __volatile__ ( \
+	"lds r26, kernelCurrent \n\t" \
+	"lds r27, kernelCurrent + 1 \n\t" \
+	"ld r28, x+ \n\t" \
+	"out __SP_L__, r28 \n\t" \
+	"ld r29, x+ \n\t" \
+	"out __SP_H__, r29 \n\t" \
+	"pop r31 \n\t" "pop r30 \n\t" "pop r29 \n\t" "pop r28 \n\t" \
+	"pop r27 \n\t" "pop r26 \n\t" "pop r25 \n\t" "pop r24 \n\t" \
+	"pop r23 \n\t" "pop r22 \n\t" "pop r21 \n\t" "pop r20 \n\t" \
+	"pop r19 \n\t" "pop r18 \n\t" "pop r17 \n\t" "pop r16 \n\t" \
+	"pop r15 \n\t" "pop r14 \n\t" "pop r13 \n\t" "pop r12 \n\t" \
+	"pop r11 \n\t" "pop r10 \n\t" "pop r9 \n\t" "pop r8 \n\t" \
+	"pop r7 \n\t" "pop r6 \n\t" "pop r5 \n\t" "pop r4 \n\t" \
+	"pop r3 \n\t" "pop r2 \n\t" \
+	"pop r1 \n\t" \
+	"pop r0 \n\t" \
+	"out __SREG__, r0 \n\t" \
+	"pop r0 \n\t" \
+)
+/*------------------------------------------------------*/
+
+
+
+/************************* GLOBAL *************************/
+struct kernelTask {
+	volatile uint8_t *sp;		// must stay the first member, used by the asm
+	uint8_t priority;
+	volatile uint8_t state;
+	volatile uint16_t delay;	// ticks left while KERNEL_DELAYED
+	void *volatile waitOn;		// semaphore or queue while KERNEL_BLOCKED
+	uint8_t *stack;				// lowest address of the stack
+	uint16_t stackSize;
+};
+
+struct kernelSem {
+	volatile uint8_t count;
+};
+
+struct kernelQueue {
+	uint8_t *buf;
+	uint8_t size;
+	volatile uint8_t head;
+	volatile uint8_t tail;
+	volatile uint8_t count;
+};
+
+struct kernel {
+	struct kernelTask *task[KERNEL_MAX_TASKS + 1]; // [0] is idle
+	uint8_t count;
+	uint8_t next;				// round robin start point
+	volatile uint32_t ticks;
+	#if KERNEL_MEASURE == YES
+		volatile uint16_t tickCycles;
+		volatile uint16_t tickCyclesMax;
+	#endif
+} kernel;
+
+struct kernelTask *volatile kernelCurrent;
+
+struct kernelTask kernelIdleTask;
+uint8_t kernelIdleStack[KERNEL_IDLE_STACK];
+/*--------------------------------------------------------*/
+
+
+
+/********************* PROTOTYPES *********************/
+void kernelYield(void) __attribute__((naked, noinline));
+void kernelYieldFromTick(void) __attribute__((naked, noinline));
+void kernelStartFirst(void) __attribute__((naked, noinline));
+/*----------------------------------------------------*/
+
+
+
+/*********************** INTERNALS ***********************/
+// picks the ready task of highest priority. Among equals the
+// search starts after the last one picked. Interrupts are off
+void kernelSwitch() {
+	struct kernelTask *best = kernel.task[0];
+	uint8_t i;
+	uint8_t n = kernel.next;
+
+	for(i=0; i<kernel.count; i++) {
+		n++;
+		if(n > kernel.count) {
+			n = 1;
+		}
+		struct kernelTask *t = kernel.task[n];
+		if(t->state == KERNEL_READY && t->priority > best->priority) {
+			best = t;
+			kernel.next = n;
+		}
+	}
+	kernelCurrent = best;
+}
+
+
+// counts down the sleeping tasks and picks the next one.
+// Runs on the stack of the interrupted task, interrupts off
+void kernelTick() {
+	uint8_t i;
+	#if KERNEL_MEASURE == YES
+		uint16_t start = TCNT1;
+		uint16_t cycles;
+	#endif
+
+	kernel.ticks++;
+	for(i=1; i<=kernel.count; i++) {
+		struct kernelTask *t = kernel.task[i];
+		if(t->state == KERNEL_DELAYED && --t->delay == 0) {
+			t->state = KERNEL_READY;
+		}
+	}
+	kernelSwitch();
+
+	#if KERNEL_MEASURE == YES
+		cycles = (TCNT1 - start) * T1_CYCLES_PER_TICK + KERNEL_CTX_CYCLES;
+		kernel.tickCycles = cycles;
+		if(cycles > kernel.tickCyclesMax) {
+			kernel.tickCyclesMax = cycles;
+		}
+	#endif
+}
+
+
+// makes the waiter of highest priority on "obj" ready. Returns
+// its priority + 1 or 0 if nobody waited. Interrupts are off
+uint8_t kernelWake(void *obj) {
+	struct kernelTask *best = 0;
+	uint8_t i;
+	for(i=1; i<=kernel.count; i++) {
+		struct kernelTask *t = kernel.task[i];
+		if(t->state == KERNEL_BLOCKED && t->waitOn == obj) {
+			if(!best || t->priority > best->priority) {
+				best = t;
+			}
+		}
+	}
+	if(!best) {
+		return 0;
+	}
+	best->state = KERNEL_READY;
+	best->waitOn = 0;
+	return best->priority + 1;
+}
+
+
+// running task waits on obj. Interrupts are off and stay off
+void kernelBlock(void *obj) {
+	kernelCurrent->state = KERNEL_BLOCKED;
+	kernelCurrent->waitOn = obj;
+	kernelYield();
+	cli();
+}
+
+
+// a task woke up one of higher priority => switch now
+void kernelPreempt(uint8_t woken) {
+	if(woken > kernelCurrent->priority + 1) {
+		kernelYield();
+	}
+}
+
+
+void kernelIdle(void *arg) {
+	#if KERNEL_IDLE_SLEEP == YES
+		set_sleep_mode(SLEEP_MODE_IDLE);
+	#endif
+	while(1) {
+		#if KERNEL_IDLE_SLEEP == YES
+			sleep_mode(); // the next tick or ISR wakes it up
+		#endif
+	}
+}
+/*-------------------------------------------------------*/
+
+
+
+/******************* USER FUNCTIONS *******************/
+void kernelTaskCreate(struct kernelTask *t, void (*func)(void *), void *arg,
+					  uint8_t priority, uint8_t *stack, uint16_t stackSize) {
+	uint16_t i;
+	uint8_t *sp;
+	uint16_t address = (uint16_t)func;
+
+	for(i=0; i<stackSize; i++) {
+		stack[i] = KERNEL_STACK_FILL;
+	}
+
+	// the first restore of the task "returns" into func(arg)
+	sp = stack + stackSize - 1;
+	*sp-- = address & 0xFF;
+	*sp-- = address >> 8;
+	*sp-- = 0x00;		// r0
+	*sp-- = 0x80;		// SREG, interrupts on
+	for(i=1; i<32; i++) {
+		if(i == 24) {
+			*sp-- = (uint16_t)arg & 0xFF;	// r24:r25 first argument
+		}
+		else if(i == 25) {
+			*sp-- = (uint16_t)arg >> 8;
+		}
+		else {
+			*sp-- = 0x00;	// r1 has to be zero for gcc
+		}
+	}
+
+	t->sp = sp;
+	t->priority = priority;
+	t->state = KERNEL_READY;
+	t->delay = 0;
+	t->waitOn = 0;
+	t->stack = stack;
+	t->stackSize = stackSize;
+
+	if(t == &kernelIdleTask) {
+		kernel.task[0] = t;
+	}
+	else if(kernel.count < KERNEL_MAX_TASKS) {
+		kernel.task[++kernel.count] = t;
+	}
+}
+
+
+void kernelStart() {
+	cli();
+	kernelTaskCreate(&kernelIdleTask, kernelIdle, 0, 0, kernelIdleStack, KERNEL_IDLE_STACK);
+	kernel.ticks = 0;
+	kernel.next = 0;
+	kernelSwitch();
+
+	#if KERNEL_MEASURE == YES
+		kernel.tickCycles = 0;
+		kernel.tickCyclesMax = 0;
+		T1freeRunStart();
+	#endif
+
+	T0operationMode(T0_OPMODE_CTC);
+	OCR0 = KERNEL_OCR;
+	TCNT0 = 0;
+	clearOC0InterruptFlag();
+	enableOC0Interrupt();
+	T0ClockSelect(T0_PRESCALER_64);
+
+	kernelStartFirst(); // does not come back
+}
+
+
+void kernelDelay(uint16_t ticks) {
+	if(!ticks) {
+		return;
+	}
+	kernelCritical();
+	kernelCurrent->delay = ticks;
+	kernelCurrent->state = KERNEL_DELAYED;
+	kernelYield();
+	kernelCriticalEnd();
+}
+
+
+uint32_t kernelTicks() {
+	kernelCritical();
+	uint32_t ticks = kernel.ticks;
+	kernelCriticalEnd();
+	return ticks;
+}
+
+
+uint16_t kernelStackFree(struct kernelTask *t) {
+	uint16_t i = 0;
+	while(i < t->stackSize && t->stack[i] == KERNEL_STACK_FILL) {
+		i++;
+	}
+	return i;
+}
+
+
+#if KERNEL_MEASURE == YES
+// share of the CPU eaten by the worst tick, in per mille
+uint16_t kernelOverhead() {
+	uint16_t cycles;
+	cli();
+	cycles = kernel.tickCyclesMax;
+	sei();
+	return ((uint32_t)cycles * KERNEL_TICK_HZ * 1000UL) / F_CPU;
+}
+#endif
+/*-----------------------------------------------------*/
+
+
+
+/********************* SEMAPHORES *********************/
+void kernelSemInit(struct kernelSem *s, uint8_t count) {
+	s->count = count;
+}
+
+
+void kernelSemTake(struct kernelSem *s) {
+	kernelCritical();
+	while(s->count == 0) {
+		kernelBlock(s);
+	}
+	s->count--;
+	kernelCriticalEnd();
+}
+
+
+void kernelSemGive(struct kernelSem *s) {
+	uint8_t woken;
+	kernelCritical();
+	s->count++;
+	woken = kernelWake(s);
+	kernelPreempt(woken);
+	kernelCriticalEnd();
+}
+
+
+void kernelSemGiveISR(struct kernelSem *s) {
+	s->count++;
+	kernelWake(s); // runs from the next tick on
+}
+/*----------------------------------------------------*/
+
+
+
+/*********************** QUEUES ***********************/
+void kernelQueueInit(struct kernelQueue *q, uint8_t *buf, uint8_t size) {
+	q->buf = buf;
+	q->size = size;
+	q->head = 0;
+	q->tail = 0;
+	q->count = 0;
+}
+
+
+void kernelQueueSend(struct kernelQueue *q, uint8_t byte) {
+	uint8_t woken;
+	kernelCritical();
+	while(q->count == q->size) {
+		kernelBlock(q);
+	}
+	q->buf[q->head] = byte;
+	q->head = (q->head + 1 == q->size) ? 0 : q->head + 1;
+	q->count++;
+	woken = kernelWake(q);
+	kernelPreempt(woken);
+	kernelCriticalEnd();
+}
+
+
+uint8_t kernelQueueReceive(struct kernelQueue *q) {
+	uint8_t byte;
+	uint8_t woken;
+	kernelCritical();
+	while(q->count == 0) {
+		kernelBlock(q);
+	}
+	byte = q->buf[q->tail];
+	q->tail = (q->tail + 1 == q->size) ? 0 : q->tail + 1;
+	q->count--;
+	woken = kernelWake(q);
+	kernelPreempt(woken);
+	kernelCriticalEnd();
+	return byte;
+}
+
+
+uint8_t kernelQueueSendISR(struct kernelQueue *q, uint8_t byte) {
+	if(q->count == q->size) {
+		return 0;
+	}
+	q->buf[q->head] = byte;
+	q->head = (q->head + 1 == q->size) ? 0 : q->head + 1;
+	q->count++;
+	kernelWake(q);
+	return 1;
+}
+
+
+uint8_t kernelQueueReceiveISR(struct kernelQueue *q, uint8_t *byte) {
+	if(q->count == 0) {
+		return 0;
+	}
+	*byte = q->buf[q->tail];
+	q->tail = (q->tail + 1 == q->size) ? 0 : q->tail + 1;
+	q->count--;
+	kernelWake(q);
+	return 1;
+}
+/*----------------------------------------------------*/
+
+
+
+/******************* CONTEXT SWITCH *******************/
+// called like a function by a task. Comes back when the task
+// is picked again, with its own SREG (interrupts as they were)
+void kernelYield(void) {
+	KERNEL_SAVE_CONTEXT();
+	kernelSwitch();
+	KERNEL_RESTORE_CONTEXT();
+	__asm__ __volatile__("ret");
+}
+
+
+// naked functions get no stack frame, so all the C work is
+// kept in kernelTick()
+void kernelYieldFromTick(void) {
+	KERNEL_SAVE_CONTEXT();
+	kernelTick();
+	KERNEL_RESTORE_CONTEXT();
+	__asm__ __volatile__("ret");
+}
+
+
+void kernelStartFirst(void) {
+	KERNEL_RESTORE_CONTEXT();
+	__asm__ __volatile__("ret");
+}
+/*----------------------------------------------------*/
+
+
+
+/************************* ISR *************************/
+ISR(TIMER0_COMP_vect, ISR_NAKED) {
+	kernelYieldFromTick();
+	__asm__ __volatile__("reti");
+}
+/*-----------------------------------------------------*/
+
+
+
+/******************* EXAMPLE CODE *******************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/rtos/kernel.h"
+#include "mega16/int/usart/usart.h"
+
+struct kernelTask taskRx, taskBlink, taskMath;
+uint8_t stackRx[96], stackBlink[64], stackMath[128];
+
+struct kernelQueue rxQueue;
+uint8_t rxBuf[16];
+
+// USART ISR hands the byte over and leaves
+void packetReceved_callpack() {
+	kernelQueueSendISR(&rxQueue, rcvPacket[0]);
+}
+
+// high priority, sleeps until a byte arrives
+void rx(void *arg) {
+	while(1) {
+		uint8_t byte = kernelQueueReceive(&rxQueue);
+		UWriteData(byte + 1);
+	}
+}
+
+void blink(void *arg) {
+	DDRA |= (1<<PA7);
+	while(1) {
+		PORTA ^= (1<<PA7);
+		kernelDelay(500);
+	}
+}
+
+// low priority, never waits. Gets preempted by the others
+void math(void *arg) {
+	volatile float x = 1.0;
+	while(1) {
+		x = x * 1.0001 + 0.5;
+	}
+}
+
+int main() {
+	USARTInit(9600);
+	kernelQueueInit(&rxQueue, rxBuf, sizeof(rxBuf));
+	kernelTaskCreate(&taskRx, rx, 0, 3, stackRx, sizeof(stackRx));
+	kernelTaskCreate(&taskBlink, blink, 0, 2, stackBlink, sizeof(stackBlink));
+	kernelTaskCreate(&taskMath, math, 0, 1, stackMath, sizeof(stackMath));
+	kernelStart();
+}
+-----------------------------------------------------*/
@@ -8,6 +8,9 @@ NOTE:
 	"softUSARTRead()" function unlike interrupt driven functions 
 	do block the execution sequence until the byte is receieved successfully.
 	The Rx interrupt driven soft USART library is also available "softUSARTIntr.h"
+	For full duplex without blocking use "softUSARTtimer.h", the bits
+	are timed by a timer ISR there.
+	To receive on several lines at once use "softUSARTmulti.h".
 
 GLOBAL STRICTURE:
 	With this library programmers can create objects of class softUsart.
@@ -19,44 +22,44 @@ GLOBAL STRICTURE:
 			usart0.rx => RXD pin for that particular usart module 
 			usart0.tx => TXD pin for that particular usart module
 			usart0.receivedByte => holds the last received data byte
+			usart0.baud => baud rate, 0 means BAUD
 
 
 
 
 USER FUNCTIONS:
 	1. initSoftUSART(&usart0); => initializes the software USART pins of usart0
+	   softUSARTSetBaud(&usart0, 19200); => changes the baud rate of usart0
 	2. softUSARTWrite(&usart0, 'a'); => writes a byte (e.g. 'a') onto TX pin of usart0
 	3. softUSARTRead(&usart0); => receieves a byte from RX pin of usart0 and will update
 								  usart0.receivedByte.	
+	4. softUSARTPrintf(&usart0, "fmt", ...); => formatted output on TX pin of usart0,
+								  format string in flash (see io/format.h)
 
 NOTE: 
 	"gpio.h" is a must. Before using any functions of this
 	library the programmer will have to call "initGPIO()".
-	Right now all usart objects will work with same baud
-	specified in user configurable area. For some reason 
-	baud rate upto 4800 is working fine and not beyond that.
-
-	When sending two bytes back to back from computer its
-	not working.
-
-
-FUTURE SCOPE:
-	I tried to specify individual baud rates for individual objects,
-	usart0.baud=2400;
-	This should calculate baud delay autometically 
-	"usart->baudDelay = 1000000UL/usart->baud;"
-	and then call soft delay instead of _delay_us().
-	Didnt work. I'm guessing either 
-	"usart->baudDelay = 1000000UL/usart->baud;" this division
-	is faulty of the soft delay function overhead messing up
-	delay timing. Have to check with oscilloscope.
+	Every usart object runs at its own baud rate, usart0.baud,
+	set before initSoftUSART() or changed later with
+	softUSARTSetBaud(). Left at 0 it takes BAUD from the user
+	configurable area. 1200 to 38400 baud work at 16Mhz.
+
+	Bits are timed with Timer1, free running at 2 Mhz, not with
+	_delay_us(). The bit time in timer ticks is kept with 8 bits
+	of fraction (1/256 tick) and every bit edge is set from the
+	start of the byte, so the error does not add up over the
+	byte and an ISR coming in between delays one edge only,
+	not all the ones after it.
+	Timer1 is shared with the other free running users (pt.h,
+	intCapture.h, T1Servo.h, logicTrace.h), other Timer1 modes
+	do not work alongside.
 ----------------------------------------------------------*/
 
 
 
 
 /******************* USER CONFIGURABLE *******************/
-#define BAUD 2400
+#define BAUD 2400 // for objects whose .baud is left 0
 /*-------------------------------------------------------*/
 
 
@@ -65,6 +68,14 @@ FUTURE SCOPE:
 #ifndef GPIO
     #include "../io/gpio.h"
 #endif
+
+#ifndef FMT_HEX
+    #include "../io/format.h"
+#endif
+
+#ifndef T1_PRESCALER_NONE
+    #include "../int/timer1/timer1.h"
+#endif
 /*--------------------------------------------------------*/
 
 
@@ -76,74 +87,141 @@ FUTURE SCOPE:
  	volatile uint8_t tx;
  	volatile uint8_t receivedByte;
  	volatile uint16_t baud;
- 	volatile uint16_t baudDelay;
+ 	volatile uint16_t bitTicks;	// Timer1 ticks per bit
+ 	volatile uint8_t bitFrac;	// and 1/256 ticks on top
  };
 /*--------------------------------------------------------*/
 
 
 /*********************** INTERNAL ***********************/
 #define BAUD_DELAY 1000000UL/BAUD
+
+#define SOFT_TICKS_PER_S (F_CPU / 8)	// Timer1 free running, prescaler 8
 /*-----------------------------------------------------*/
 
 
 
+/*********************** INTERNALS ***********************/
+// moves the deadline on by one bit, carrying the fraction,
+// and waits for it
+static inline void softBitWait(uint16_t *due, uint8_t *frac, uint16_t ticks, uint8_t step) {
+	uint8_t f = *frac;
+	*frac = f + step;
+	*due += ticks;
+	if(*frac < f) {
+		(*due)++;
+	}
+	while((int16_t)(TCNT1 - *due) < 0);
+}
+
+
+// the 8 data bits of a byte whose start bit fell at Timer1 time
+// "edge". Returns at the middle of the stop bit
+uint8_t softRxBits(struct softUsart *usart, uint16_t edge) {
+	uint16_t ticks = usart->bitTicks;
+	uint8_t step = usart->bitFrac;
+	uint16_t due = edge + (ticks >> 1);
+	uint8_t frac = (step >> 1) | ((ticks & 1) << 7);
+	uint8_t byte = 0;
+	uint8_t i;
+
+	// middle of the start bit, then one bit on each time
+	while((int16_t)(TCNT1 - due) < 0);
+	for(i=0; i<8; i++) {
+		softBitWait(&due, &frac, ticks, step);
+		byte >>= 1;
+		if(getInput(usart->rx)) {
+			byte |= 0x80;
+		}
+	}
+	softBitWait(&due, &frac, ticks, step);
+	return byte;
+}
+/*-------------------------------------------------------*/
+
+
+
 
 
 /******************* USER FUNCTIONS *******************/
+void softUSARTSetBaud(struct softUsart *usart, uint16_t baud) {
+	// Timer1 ticks per bit, 8.8 fixed point, rounded
+	uint32_t t = ((SOFT_TICKS_PER_S << 8) + baud / 2) / baud;
+	usart->baud = baud;
+	usart->bitTicks = t >> 8;
+	usart->bitFrac = t;
+}
+
+
 void initSoftUSART(struct softUsart *usart) {
 	usart->receivedByte = 0;
 	inHigh(usart->rx);  // active low bus
 	outHigh(usart->tx); // idle state is high
-	usart->baudDelay = 1000000UL/usart->baud;
+	softUSARTSetBaud(usart, usart->baud ? usart->baud : BAUD);
+	T1freeRunStart();
 }
 
 
-// This function send a byte of data through TX_POS defined above
+// This function send a byte of data through the TX pin of usart
 void softUSARTWrite(struct softUsart *usart, uint8_t byte) {
+	uint16_t ticks = usart->bitTicks;
+	uint8_t step = usart->bitFrac;
+	uint8_t frac = 0;
+	uint16_t due;
+	uint8_t i;
+
 	//send start bit
 	outLow(usart->tx);
-	_delay_us(BAUD_DELAY);
-	//soft_delay_us(BAUD_DELAY);
-	// send data byte LSB to MSB
-	uint8_t i;
-	for(i=0; i<8; i++) {
-		if(byte & 0b00000001) {
+	due = TCNT1;
+	// send data byte LSB to MSB, then the stop bit
+	for(i=0; i<9; i++) {
+		softBitWait(&due, &frac, ticks, step);
+		if(i == 8 || (byte & 0b00000001)) {
 			outHigh(usart->tx);
 		}
 		else {
 			outLow(usart->tx);
 		}
-		_delay_us(BAUD_DELAY);
-		//soft_delay_us(BAUD_DELAY);
 		// shift data 1 bit to the right
 		byte = (byte>>1);
 	}
-	//send stop condition
-	outHigh(usart->tx);
+	// let the stop bit run its full length
+	softBitWait(&due, &frac, ticks, step);
 }
 
 
-// This function receieves a byte of data through RX_POS defined above
+// This function receieves a byte of data through the RX pin of usart
 void softUSARTRead(struct softUsart *usart) {
-	uint8_t byte=0x00;
-	uint8_t i;
+	uint16_t edge;
 	if(!getInput(usart->rx)) { // !!!! Caution This functions blocks the execution untill a byte is receieved !!!!
 		return; // Error condition, data receieve in progress
 	}
 
 	while(getInput(usart->rx)); // wait unless idle
 	//if a start bit is receieved 
-	_delay_us(BAUD_DELAY>>2); //.5 delay; go to the middle of start bit.
-	// sample the following 8 data bits
-	for(i=0; i<8; i++) {
-		_delay_us(BAUD_DELAY);
-		// sample the first bit
-		if(getInput(usart->rx)) {
-			byte |= (1<<i);
-		}	
-	}
-	usart->receivedByte = byte;
+	edge = TCNT1;
+	usart->receivedByte = softRxBits(usart, edge);
+}
+
+
+// sink for io/format.h, writes to the usart handed to softUSARTPrintf()
+struct softUsart *softFmtUsart;
+
+void softFmtSink(uint8_t c) {
+	softUSARTWrite(softFmtUsart, c);
 }
+
+
+void softUSARTPrintf_P(struct softUsart *usart, const char *fmt, ...) {
+	va_list ap;
+	softFmtUsart = usart;
+	va_start(ap, fmt);
+	fmtVPrint_P(softFmtSink, fmt, ap);
+	va_end(ap);
+}
+
+
+#define softUSARTPrintf(usart, fmt, ...) softUSARTPrintf_P((usart), PSTR(fmt), ##__VA_ARGS__)
 /*--------------------------------------------------------*/
 
 
@@ -158,17 +236,23 @@ void softUSARTRead(struct softUsart *usart) {
 #include "mega16/softUSART/softUSART.h"
 
 struct softUsart usart0;
+struct softUsart usart1;
 
 int main() {
     initGPIO();
     usart0.rx = A0;
     usart0.tx = A1;
+    usart0.baud = 9600;
+    usart1.rx = A2;
+    usart1.tx = A3;
+    usart1.baud = 38400;
 
     initSoftUSART(&usart0);
-    uint8_t data,i;
+    initSoftUSART(&usart1);
     while(1) {
+        // whatever comes in at 9600 goes out at 38400
         softUSARTRead(&usart0);
-        softUSARTWrite(&usart0, usart0.receivedByte+1);
+        softUSARTWrite(&usart1, usart0.receivedByte);
     }
 }
 ----------------------------------------------------------*/
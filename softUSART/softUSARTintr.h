@@ -14,14 +14,20 @@ USER FUNCTIONS:
 	2. softUSARTWrite(&usart0, 'a') 	// to send byte (e.g. 'a') through TX of usart0
 	3. softUsartData.receivedByte 		// holds the recently received byte
 	4. softUsartData.justReceivedFlag 	// this flag sets when softUsartData.receivedByte is updated with new byte 
+	5. softUSARTAvailable() 			// bytes waiting in the receive ring
+	6. softUSARTGet(&byte) 				// takes the oldest received byte, 0 if none
+	7. softUsartData.lost 				// bytes dropped because the ring was full
 
 NOTE:
 	1. if "RX_CALLBACK" is set to "YES"  the the programmer has to define "softRX_callback()" else the program WILL NOT COMPILE.
 	2. Connect RX wire to appropriate INTx PIN.
-	5. Baud rate defined in softUSART.h
+	5. Baud rate is usart0.baud, or BAUD of softUSART.h if left 0
 	4. the received byte will not be updated within object property, 
 	   rather will be updated in "softUsartData.receivedByte"	for
 	   all virtual usart modules
+	6. Every received byte also goes into a ring SOFT_RX_DEPTH
+	   bytes deep, so bytes coming faster than the main loop
+	   reads receivedByte are kept. Read them with softUSARTGet().
  ------------------------------------------------------*/
 
 
@@ -39,12 +45,17 @@ NOTE:
 /******************* USER CONFIGURABLE *******************/
 #define INTR_PIN_RX INTR0 // possible options are INTR0(PD2), INTR1(PD3), INTR2(PB2)
 #define RX_CALLBACK YES // possiable options YES, NO
+#define SOFT_RX_DEPTH 16 // received bytes kept till read. 2, 4, 8 ... 128
 /*-------------------------------------------------------*/
 
 
 /******************* INCLUDE DEPENDENCY *******************/
 #include "softUSART.h"
 
+#ifndef RING_TYPE
+	#include "../io/ring.h"
+#endif
+
 #undef RX_DDR
 #undef RX_PORT
 #undef RX_PIN
@@ -77,9 +88,14 @@ NOTE:
 
 
 /******************** GOBAL VARIABLES ********************/
+RING_TYPE(softRxRing, uint8_t, SOFT_RX_DEPTH)
+
 struct softUsartIntr {
+	struct softUsart *usart;	// the one on the INTx pin
 	uint8_t receivedByte;
 	uint8_t justReceivedFlag;
+	struct softRxRing rx;
+	volatile uint8_t lost;
 } softUsartData; 
 /*-------------------------------------------------------*/
 
@@ -89,6 +105,11 @@ struct softUsartIntr {
 /********************* USER FUNCTIONS *********************/
 void initSoftUSARTintr(struct softUsart *usart){
 	usart->receivedByte = 0;
+	softUsartData.usart = usart;
+	softUSARTSetBaud(usart, usart->baud ? usart->baud : BAUD);
+	T1freeRunStart();
+	softRxRingInit(&softUsartData.rx);
+	softUsartData.lost = 0;
 	inHigh(usart->rx);  // active low bus
 	outHigh(usart->tx); // idle state is high
 	cli();
@@ -113,6 +134,10 @@ void initSoftUSARTintr(struct softUsart *usart){
 	#endif
 	sei();
 }
+
+
+#define softUSARTAvailable() softRxRingCount(&softUsartData.rx)
+#define softUSARTGet(byte) softRxRingPop(&softUsartData.rx, (byte))
 /*--------------------------------------------------------*/
 
 
@@ -121,65 +146,31 @@ void initSoftUSARTintr(struct softUsart *usart){
 /*********************** INTERNALS ***********************/
 void softRX_callback(void); //	function prototype
 
+static inline void softRxStore(uint8_t byte) {
+	softUsartData.receivedByte = byte;
+	softUsartData.justReceivedFlag = 1;
+	if(!softRxRingPush(&softUsartData.rx, byte)) {
+		softUsartData.lost++;
+	}
+	#if RX_CALLBACK == YES
+		softRX_callback();
+	#endif
+}
+
 #if INTR_PIN_RX == INTR0
 	void int0_Callback() {
-		uint8_t byte=0x00;
-		uint8_t i;
-	 
-		_delay_us(BAUD_DELAY>>2); //.5 delay; go to the middle of start bit.
-		// sample the following 8 data bits
-		for(i=0; i<8; i++) {
-			_delay_us(BAUD_DELAY);
-			// sample the first bit
-			if(RX_PIN & (1<<RX_POS)) {
-				byte |= (1<<i);
-			}	
-		}
-		softUsartData.receivedByte = byte;
-		softUsartData.justReceivedFlag = 1;
-		#if RX_CALLBACK == YES
-			softRX_callback();
-		#endif
+		// the start bit fell just before, bits timed at the baud of the usart
+		softRxStore(softRxBits(softUsartData.usart, TCNT1));
 	}
 #elif INTR_PIN_RX == INTR1
 	void int1_Callback() {
-		uint8_t byte=0x00;
-		uint8_t i;
-	 
-		_delay_us(BAUD_DELAY>>2); //.5 delay; go to the middle of start bit.
-		// sample the following 8 data bits
-		for(i=0; i<8; i++) {
-			_delay_us(BAUD_DELAY);
-			// sample the first bit
-			if(RX_PIN & (1<<RX_POS)) {
-				byte |= (1<<i);
-			}	
-		}
-		softUsartData.receivedByte = byte;
-		softUsartData.justReceivedFlag = 1;
-		#if RX_CALLBACK == YES
-			softRX_callback();
-		#endif
+		// the start bit fell just before, bits timed at the baud of the usart
+		softRxStore(softRxBits(softUsartData.usart, TCNT1));
 	}
 #elif INTR_PIN_RX == INTR2
 	void int2_Callback() {
-		uint8_t byte=0x00;
-		uint8_t i;
-	 
-		_delay_us(BAUD_DELAY>>2); //.5 delay; go to the middle of start bit.
-		// sample the following 8 data bits
-		for(i=0; i<8; i++) {
-			_delay_us(BAUD_DELAY);
-			// sample the first bit
-			if(RX_PIN & (1<<RX_POS)) {
-				byte |= (1<<i);
-			}	
-		}
-		softUsartData.receivedByte = byte;
-		softUsartData.justReceivedFlag = 1;
-		#if RX_CALLBACK == YES
-			softRX_callback();
-		#endif
+		// the start bit fell just before, bits timed at the baud of the usart
+		softRxStore(softRxBits(softUsartData.usart, TCNT1));
 	}
 #endif
 /*--------------------------------------------------------*/
@@ -195,6 +186,7 @@ void softRX_callback(void); //	function prototype
 
 #undef INTR_PIN_RX
 #undef RX_CALLBACK
+#undef SOFT_RX_DEPTH
 
 #undef RX_DDR
 #undef RX_PORT
@@ -226,9 +218,15 @@ int main() {
     LCDClear();
     _delay_ms(100);
    
+    uint8_t byte;
+
     while(1) {
         _delay_ms(500);
         LCDWriteIntXY(0,0,softUsartData.receivedByte,3);
+        // bytes that came during the delays are still in the ring
+        while(softUSARTGet(&byte)) {
+            LCDWriteIntXY(4,0,byte,3);
+        }
         _delay_ms(100);
     }
 }
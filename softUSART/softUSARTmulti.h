@@ -0,0 +1,452 @@
+/********************* DESCRIPTION *********************
+Receives on upto 8 soft USART RX lines at the same time, from
+one timer ISR. softUSARTintr.h takes one RX line on an INTx pin
+and one softUsartData for all, this takes any pins and keeps the
+channels apart, e.g. for a handful of serial sensors.
+
+A timer in CTC mode interrupts at 3 times the baud rate. Each
+tick the ISR reads PINA..PIND once and packs the RX pins into one
+byte, bit n = channel n. All the work is then done on whole bytes,
+8 channels at once (bit sliced):
+
+	- a low on an idle channel is a start bit
+	- every channel has its own bit clock: one of the 3 ticks of
+	  each bit, fixed by when its start bit came
+	- a bit is the majority of its 3 samples, so a spike shorter
+	  than one tick is out voted
+	- bit counters and shift registers are kept as bit planes,
+	  one byte per counter bit and per data bit
+
+Only a finished byte is handled per channel. It goes into one
+RX ring shared by all channels, along with its channel number.
+
+Frame: 8 data bits, no parity, 1 stop bit (8N1), LSB first.
+All channels run at the same baud rate.
+
+USER FUNCTIONS:
+	1. mUSARTInit(); 				=> pins, ring, timer. Turns interrupts on
+	2. mUSARTAvailable(); 			=> received bytes waiting (all channels)
+	3. mUSARTRead(&rx); 			=> takes the oldest byte. 0 if none
+									   rx.ch => channel, rx.data => byte
+	4. mUSARTStop(); 				=> timer off
+	5. mUsart.lost 					=> bytes dropped, ring full
+	6. mUsart.frameErr[ch] 			=> bytes with a low stop bit, per channel
+
+NOTE:
+	Uses Timer0 or Timer2 (MUSART_TIMER) in CTC mode with its
+	compare match ISR. When softUSARTtimer.h is used too, the two
+	must be on different timers.
+	A tick costs about 60 cycles with no bit due and about 150
+	when bits are due, a finished byte adds about 50 per channel.
+	Baud rates that leave less than MUSART_MIN_CYCLES per tick do
+	not compile, which is 9600 baud at 16Mhz.
+	Majority voting takes samples across the whole bit, so the
+	baud rate of the senders must be within about 2% of
+	MUSART_BAUD.
+ ------------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#undef YES
+#undef NO
+#define YES 1
+#define NO 2
+
+#define MUSART_T0 0
+#define MUSART_T2 2
+/*------------------------------------------------------*/
+
+
+
+/******************* USER CONFIGURABLE *******************/
+#define MUSART_TIMER MUSART_T0	// MUSART_T0 or MUSART_T2
+#define MUSART_BAUD 9600
+#define MUSART_CHANNELS 4		// 1 ... 8
+#define MUSART_DEPTH 32			// received bytes kept till read. 2, 4, 8 ... 128
+#define MUSART_PULL_UP YES		// internal pull ups on the RX pins
+
+// RX pin of every channel: port letter, bit. Only the first
+// MUSART_CHANNELS are used
+#define MUSART_CH0 C, 0
+#define MUSART_CH1 C, 1
+#define MUSART_CH2 C, 2
+#define MUSART_CH3 C, 3
+#define MUSART_CH4 C, 4
+#define MUSART_CH5 C, 5
+#define MUSART_CH6 C, 6
+#define MUSART_CH7 C, 7
+/*-------------------------------------------------------*/
+
+
+
+/********************* DEPENDENCY *********************/
+#ifndef RING_TYPE
+	#include "../io/ring.h"
+#endif
+
+#if MUSART_CHANNELS < 1 || MUSART_CHANNELS > 8
+	#error MUSART_CHANNELS MUST BE 1 ... 8
+#endif
+#define MUSART_MASK ((uint8_t)((1 << MUSART_CHANNELS) - 1))
+
+// fewest CPU cycles per tick that leave the main loop some time
+#define MUSART_MIN_CYCLES 400
+
+// CPU cycles per tick, then the smallest prescaler that fits 8 bit
+#define MUSART_CYCLES (F_CPU / (3UL * MUSART_BAUD))
+
+#if MUSART_CYCLES < MUSART_MIN_CYCLES
+	#error MUSART_BAUD TOO HIGH FOR THIS F_CPU
+#elif MUSART_CYCLES <= 256
+	#define MUSART_PRESCALER 1
+#elif MUSART_CYCLES <= 256UL * 8
+	#define MUSART_PRESCALER 8
+#elif MUSART_CYCLES <= 256UL * 64
+	#define MUSART_PRESCALER 64
+#elif MUSART_CYCLES <= 256UL * 256
+	#define MUSART_PRESCALER 256
+#else
+	#error MUSART_BAUD TOO LOW FOR THIS F_CPU
+#endif
+
+#define MUSART_OCR ((F_CPU + 3UL * MUSART_BAUD * MUSART_PRESCALER / 2) / (3UL * MUSART_BAUD * MUSART_PRESCALER) - 1)
+
+// tick rate error in per mille
+#define MUSART_TICK_RATE (F_CPU / (MUSART_PRESCALER * (MUSART_OCR + 1)))
+#if MUSART_TICK_RATE > 3UL * MUSART_BAUD
+	#define MUSART_ERR ((MUSART_TICK_RATE - 3UL * MUSART_BAUD) * 1000 / (3UL * MUSART_BAUD))
+#else
+	#define MUSART_ERR ((3UL * MUSART_BAUD - MUSART_TICK_RATE) * 1000 / (3UL * MUSART_BAUD))
+#endif
+#if MUSART_ERR > 10
+	#error MUSART_BAUD ERROR ABOVE 1% FOR THIS F_CPU
+#endif
+
+#if MUSART_TIMER == MUSART_T0
+	#if MUSART_PRESCALER == 1
+		#define MUSART_CS 1
+	#elif MUSART_PRESCALER == 8
+		#define MUSART_CS 2
+	#elif MUSART_PRESCALER == 64
+		#define MUSART_CS 3
+	#else
+		#define MUSART_CS 4
+	#endif
+#elif MUSART_TIMER == MUSART_T2
+	#if MUSART_PRESCALER == 1
+		#define MUSART_CS 1
+	#elif MUSART_PRESCALER == 8
+		#define MUSART_CS 2
+	#elif MUSART_PRESCALER == 64
+		#define MUSART_CS 4
+	#else
+		#define MUSART_CS 6
+	#endif
+#else
+	#error MUSART_TIMER MUST BE MUSART_T0 OR MUSART_T2
+#endif
+/*----------------------------------------------------*/
+
+
+
+/*********************** MACROS ***********************/
+// the extra level lets "C, 0" split into port and bit
+#define MUSART_TAKE(in, ch, pin) MUSART_TAKE_(in, ch, pin)
+#define MUSART_TAKE_(in, ch, port, bit) \
+	if(pin##port & (1<<(bit))) { \
+		in |= (1<<(ch)); \
+	}
+
+#define MUSART_INPUT(pin) MUSART_INPUT_(pin)
+#if MUSART_PULL_UP == YES
+	#define MUSART_INPUT_(port, bit) \
+		DDR##port &= ~(1<<(bit)); \
+		PORT##port |= (1<<(bit));
+#else
+	#define MUSART_INPUT_(port, bit) \
+		DDR##port &= ~(1<<(bit));
+#endif
+/*----------------------------------------------------*/
+
+
+
+/*********************** GLOBAL ***********************/
+struct mUsartByte {
+	uint8_t ch;
+	uint8_t data;
+};
+
+RING_TYPE(mUsartRing, struct mUsartByte, MUSART_DEPTH)
+
+// bit n of every byte below belongs to channel n
+struct mUsart {
+	struct mUsartRing rx;
+	uint8_t h1;				// samples one tick ago
+	uint8_t h2;				// samples two ticks ago
+	uint8_t busy;			// receiving a byte
+	uint8_t clock[3];		// channels whose bit ends at tick 0, 1, 2
+	uint8_t phase;			// tick 0, 1, 2 now
+	uint8_t count[4];		// bits done in the byte, bit planes, LSB first
+	uint8_t data[8];		// shift registers, bit planes, data[0] => LSB
+	volatile uint8_t lost;
+	volatile uint8_t frameErr[MUSART_CHANNELS];
+} mUsart;
+/*----------------------------------------------------*/
+
+
+
+/*********************** INTERNALS ***********************/
+// the 3 samples of a bit just ended on the channels in "due"
+static inline void mUsartBits(uint8_t due, uint8_t bit) {
+	uint8_t *c = mUsart.count;
+	uint8_t first = due & ~(c[0] | c[1] | c[2] | c[3]);		// count 0
+	uint8_t stop = due & c[0] & ~c[1] & ~c[2] & c[3];		// count 9
+	uint8_t falseStart = first & bit;						// start bit out voted
+	uint8_t shift = due & ~first & ~stop;					// data bits
+	uint8_t run = due & ~stop & ~falseStart;
+	uint8_t end = stop | falseStart;
+	uint8_t carry;
+	uint8_t i;
+
+	if(shift) {
+		for(i=0; i<7; i++) {
+			mUsart.data[i] ^= (mUsart.data[i] ^ mUsart.data[i + 1]) & shift;
+		}
+		mUsart.data[7] ^= (mUsart.data[7] ^ bit) & shift;
+	}
+
+	// count + 1 on all running channels at once
+	carry = run;
+	for(i=0; i<4 && carry; i++) {
+		c[i] ^= carry;
+		carry &= ~c[i]; // bit went 1 => 0
+	}
+
+	if(end) {
+		for(i=0; i<4; i++) {
+			c[i] &= ~end;
+		}
+		mUsart.busy &= ~end;
+		mUsart.clock[mUsart.phase] &= ~end;
+	}
+
+	// a finished byte is taken out of the planes one channel at a time
+	if(stop) {
+		struct mUsartByte rx;
+		uint8_t mask;
+		uint8_t j;
+		for(rx.ch=0, mask=1; rx.ch<MUSART_CHANNELS; rx.ch++, mask<<=1) {
+			if(!(stop & mask)) {
+				continue;
+			}
+			if(!(bit & mask)) {
+				mUsart.frameErr[rx.ch]++;
+				continue;
+			}
+			rx.data = 0;
+			for(j=8; j--; ) {
+				rx.data <<= 1;
+				if(mUsart.data[j] & mask) {
+					rx.data |= 1;
+				}
+			}
+			if(!mUsartRingPush(&mUsart.rx, rx)) {
+				mUsart.lost++;
+			}
+		}
+	}
+}
+/*-------------------------------------------------------*/
+
+
+
+/******************* USER FUNCTIONS *******************/
+void mUSARTInit() {
+	uint8_t i;
+	cli();
+	mUsartRingInit(&mUsart.rx);
+	mUsart.h1 = MUSART_MASK;
+	mUsart.h2 = MUSART_MASK;
+	mUsart.busy = 0;
+	mUsart.phase = 0;
+	for(i=0; i<3; i++) {
+		mUsart.clock[i] = 0;
+	}
+	for(i=0; i<4; i++) {
+		mUsart.count[i] = 0;
+	}
+	mUsart.lost = 0;
+	for(i=0; i<MUSART_CHANNELS; i++) {
+		mUsart.frameErr[i] = 0;
+	}
+
+	MUSART_INPUT(MUSART_CH0)
+	#if MUSART_CHANNELS > 1
+		MUSART_INPUT(MUSART_CH1)
+	#endif
+	#if MUSART_CHANNELS > 2
+		MUSART_INPUT(MUSART_CH2)
+	#endif
+	#if MUSART_CHANNELS > 3
+		MUSART_INPUT(MUSART_CH3)
+	#endif
+	#if MUSART_CHANNELS > 4
+		MUSART_INPUT(MUSART_CH4)
+	#endif
+	#if MUSART_CHANNELS > 5
+		MUSART_INPUT(MUSART_CH5)
+	#endif
+	#if MUSART_CHANNELS > 6
+		MUSART_INPUT(MUSART_CH6)
+	#endif
+	#if MUSART_CHANNELS > 7
+		MUSART_INPUT(MUSART_CH7)
+	#endif
+
+	#if MUSART_TIMER == MUSART_T0
+		TCCR0 = (1<<WGM01) | MUSART_CS; // CTC
+		TCNT0 = 0;
+		OCR0 = MUSART_OCR;
+		TIFR = (1<<OCF0);
+		TIMSK |= (1<<OCIE0);
+	#else
+		TCCR2 = (1<<WGM21) | MUSART_CS; // CTC
+		TCNT2 = 0;
+		OCR2 = MUSART_OCR;
+		TIFR = (1<<OCF2);
+		TIMSK |= (1<<OCIE2);
+	#endif
+	sei();
+}
+
+
+void mUSARTStop() {
+	#if MUSART_TIMER == MUSART_T0
+		TIMSK &= ~(1<<OCIE0);
+		TCCR0 = 0;
+	#else
+		TIMSK &= ~(1<<OCIE2);
+		TCCR2 = 0;
+	#endif
+	mUsart.busy = 0;
+	mUsart.clock[0] = 0;
+	mUsart.clock[1] = 0;
+	mUsart.clock[2] = 0;
+	mUsart.count[0] = 0;
+	mUsart.count[1] = 0;
+	mUsart.count[2] = 0;
+	mUsart.count[3] = 0;
+}
+
+
+#define mUSARTAvailable() mUsartRingCount(&mUsart.rx)
+#define mUSARTRead(byte) mUsartRingPop(&mUsart.rx, (byte))
+/*-----------------------------------------------------*/
+
+
+
+/************************* ISR *************************/
+#if MUSART_TIMER == MUSART_T0
+	#ifdef ISR_DISPATCH
+		#define ISR_CLAIM_TIMER0_COMP
+		#include "../int/isr/isrClaim.h"
+		SHARED_ISR
+	#else
+		ISR(TIMER0_COMP_vect)
+	#endif
+#else
+	#ifdef ISR_DISPATCH
+		#define ISR_CLAIM_TIMER2_COMP
+		#include "../int/isr/isrClaim.h"
+		SHARED_ISR
+	#else
+		ISR(TIMER2_COMP_vect)
+	#endif
+#endif
+{
+	// every port once, all pins sampled at the same moment
+	uint8_t pinA __attribute__((unused)) = PINA;
+	uint8_t pinB __attribute__((unused)) = PINB;
+	uint8_t pinC __attribute__((unused)) = PINC;
+	uint8_t pinD __attribute__((unused)) = PIND;
+	uint8_t in = 0;
+	uint8_t h1 = mUsart.h1;
+	uint8_t h2 = mUsart.h2;
+	uint8_t due = mUsart.clock[mUsart.phase];
+	uint8_t start;
+
+	MUSART_TAKE(in, 0, MUSART_CH0)
+	#if MUSART_CHANNELS > 1
+		MUSART_TAKE(in, 1, MUSART_CH1)
+	#endif
+	#if MUSART_CHANNELS > 2
+		MUSART_TAKE(in, 2, MUSART_CH2)
+	#endif
+	#if MUSART_CHANNELS > 3
+		MUSART_TAKE(in, 3, MUSART_CH3)
+	#endif
+	#if MUSART_CHANNELS > 4
+		MUSART_TAKE(in, 4, MUSART_CH4)
+	#endif
+	#if MUSART_CHANNELS > 5
+		MUSART_TAKE(in, 5, MUSART_CH5)
+	#endif
+	#if MUSART_CHANNELS > 6
+		MUSART_TAKE(in, 6, MUSART_CH6)
+	#endif
+	#if MUSART_CHANNELS > 7
+		MUSART_TAKE(in, 7, MUSART_CH7)
+	#endif
+
+	if(due) {
+		// 2 of 3 samples, all channels at once
+		mUsartBits(due, (in & h1) | (in & h2) | (h1 & h2));
+	}
+
+	// a low on an idle channel starts a byte. Its first bit ends
+	// 2 ticks from now, and every 3rd tick after that
+	start = ~mUsart.busy & ~in & MUSART_MASK;
+	if(start) {
+		mUsart.busy |= start;
+		mUsart.clock[mUsart.phase == 0 ? 2 : mUsart.phase - 1] |= start;
+	}
+
+	mUsart.h2 = h1;
+	mUsart.h1 = in;
+	if(++mUsart.phase == 3) {
+		mUsart.phase = 0;
+	}
+}
+/*-----------------------------------------------------*/
+
+
+
+/******************* EXAMPLE CODE *******************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/int/usart/usart.h"
+#include "mega16/softUSART/softUSARTmulti.h"
+
+// four 9600 baud sensors on PC0..PC3, forwarded to the hardware
+// USART with the channel in front: "2:$GPGGA,..."
+int main() {
+	struct mUsartByte rx;
+	uint8_t last = 0xFF;
+
+	USARTInit(115200);
+	mUSARTInit();
+
+	while(1) {
+		while(mUSARTRead(&rx)) {
+			if(rx.ch != last) {
+				UPrintf("\r\n%u:", rx.ch);
+				last = rx.ch;
+			}
+			UWriteData(rx.data);
+		}
+		_delay_ms(5); // bytes keep coming in meanwhile
+	}
+}
+-----------------------------------------------------*/
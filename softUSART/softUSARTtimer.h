@@ -0,0 +1,371 @@
+/********************* DESCRIPTION *********************
+Soft USART run by a timer. softUSART.h times every bit with
+_delay_us(), so the CPU is stuck for the whole byte and any ISR
+that comes in between stretches a bit and breaks the byte. Here
+a timer in CTC mode interrupts at 3 times the baud rate and the
+ISR does one small step per tick:
+
+	TX => every 3rd tick the next bit goes out on the TX pin
+	RX => the RX pin is read every tick. A low on an idle line is
+		  a start bit, from then on the pin is read every 3rd
+		  tick, near the middle of each bit
+
+Bytes to send wait in a TX ring, received bytes in an RX ring,
+so TX and RX run at the same time (full duplex) and the main
+loop only touches the rings.
+
+Frame: 8 data bits, no parity, 1 stop bit (8N1), LSB first.
+
+USER FUNCTIONS:
+	1. tUSARTInit(); 					=> pins, rings, timer. Turns interrupts on
+	2. tUSARTWrite(byte); 				=> queues a byte. Waits while the TX ring
+										   is full. 0 if dropped (interrupts off)
+	3. tUSARTPrint("text"); 			=> queues a string in RAM
+	4. tUSARTPrintf("fmt", ...); 		=> formatted output (see io/format.h)
+	5. tUSARTFlush(); 					=> waits till the last byte is out
+	6. tUSARTAvailable(); 				=> received bytes waiting
+	7. tUSARTRead(&byte); 				=> takes the oldest received byte. 0 if none
+	8. tUSARTStop(); 					=> timer off, TX pin stays high
+	9. tUsart.lost, tUsart.frameErr 	=> bytes dropped (RX ring full),
+										   bytes with a low stop bit
+
+NOTE:
+	Uses Timer0 or Timer2 (TUSART_TIMER) in CTC mode with its
+	compare match ISR, so that timer is not free for anything
+	else (Timer2 => no T2timeKeeper.h, Timer0 => no ptKernel
+	tick on TIMER0_COMP) unless isrDispatch.h shares the ISR and
+	both agree on the timer setup.
+	The ISR takes about 60 to 100 cycles and comes every
+	F_CPU / (3 * TUSART_BAUD) cycles: at 16Mhz and 19200 baud
+	every 277 cycles, so about a third of the CPU. Baud rates
+	that leave less than TUSART_MIN_CYCLES per tick do not
+	compile. Other ISRs may delay a tick by up to a third of a
+	bit without harm. Longer ones (e.g. softUSART.h writes, long
+	callbacks) break bytes.
+	The pins are set here as port registers, not gpio.h numbers:
+	the ISR can not afford the gpio.h lookup on every tick.
+ ------------------------------------------------------*/
+
+
+
+/*********************** INTERNAL ***********************/
+#undef YES
+#undef NO
+#define YES 1
+#define NO 2
+
+#define TUSART_T0 0
+#define TUSART_T2 2
+/*------------------------------------------------------*/
+
+
+
+/******************* USER CONFIGURABLE *******************/
+#define TUSART_TIMER TUSART_T2	// TUSART_T0 or TUSART_T2
+#define TUSART_BAUD 9600		// upto 19200 at 16Mhz
+#define TUSART_TX_DEPTH 32		// bytes waiting to be sent. 2, 4, 8 ... 128
+#define TUSART_RX_DEPTH 32		// received bytes kept till read. 2, 4, 8 ... 128
+
+#define TUSART_TX_DDR DDRD
+#define TUSART_TX_PORT PORTD
+#define TUSART_TX_POS PD5
+
+#define TUSART_RX_DDR DDRD
+#define TUSART_RX_PORT PORTD
+#define TUSART_RX_PIN PIND
+#define TUSART_RX_POS PD6
+/*-------------------------------------------------------*/
+
+
+
+/********************* DEPENDENCY *********************/
+#ifndef RING_TYPE
+	#include "../io/ring.h"
+#endif
+
+#ifndef FMT_HEX
+	#include "../io/format.h"
+#endif
+
+// fewest CPU cycles per tick that leave the main loop some time
+#define TUSART_MIN_CYCLES 200
+
+// CPU cycles per tick, then the smallest prescaler that fits 8 bit
+#define TUSART_CYCLES (F_CPU / (3UL * TUSART_BAUD))
+
+#if TUSART_CYCLES < TUSART_MIN_CYCLES
+	#error TUSART_BAUD TOO HIGH FOR THIS F_CPU
+#elif TUSART_CYCLES <= 256
+	#define TUSART_PRESCALER 1
+#elif TUSART_CYCLES <= 256UL * 8
+	#define TUSART_PRESCALER 8
+#elif TUSART_CYCLES <= 256UL * 64
+	#define TUSART_PRESCALER 64
+#elif TUSART_CYCLES <= 256UL * 256
+	#define TUSART_PRESCALER 256
+#else
+	#error TUSART_BAUD TOO LOW FOR THIS F_CPU
+#endif
+
+#define TUSART_OCR ((F_CPU + 3UL * TUSART_BAUD * TUSART_PRESCALER / 2) / (3UL * TUSART_BAUD * TUSART_PRESCALER) - 1)
+
+// tick rate error in per mille. Sampling 3 times per bit leaves
+// less room than the hardware USART, so keep it small
+#define TUSART_TICK_RATE (F_CPU / (TUSART_PRESCALER * (TUSART_OCR + 1)))
+#if TUSART_TICK_RATE > 3UL * TUSART_BAUD
+	#define TUSART_ERR ((TUSART_TICK_RATE - 3UL * TUSART_BAUD) * 1000 / (3UL * TUSART_BAUD))
+#else
+	#define TUSART_ERR ((3UL * TUSART_BAUD - TUSART_TICK_RATE) * 1000 / (3UL * TUSART_BAUD))
+#endif
+#if TUSART_ERR > 20
+	#error TUSART_BAUD ERROR ABOVE 2% FOR THIS F_CPU
+#endif
+
+#if TUSART_TIMER == TUSART_T0
+	#if TUSART_PRESCALER == 1
+		#define TUSART_CS 1
+	#elif TUSART_PRESCALER == 8
+		#define TUSART_CS 2
+	#elif TUSART_PRESCALER == 64
+		#define TUSART_CS 3
+	#else
+		#define TUSART_CS 4
+	#endif
+#elif TUSART_TIMER == TUSART_T2
+	#if TUSART_PRESCALER == 1
+		#define TUSART_CS 1
+	#elif TUSART_PRESCALER == 8
+		#define TUSART_CS 2
+	#elif TUSART_PRESCALER == 64
+		#define TUSART_CS 4
+	#else
+		#define TUSART_CS 6
+	#endif
+#else
+	#error TUSART_TIMER MUST BE TUSART_T0 OR TUSART_T2
+#endif
+/*----------------------------------------------------*/
+
+
+
+/*********************** GLOBAL ***********************/
+RING_TYPE(tUsartTxRing, uint8_t, TUSART_TX_DEPTH)
+RING_TYPE(tUsartRxRing, uint8_t, TUSART_RX_DEPTH)
+
+struct tUsart {
+	struct tUsartTxRing tx;	// main loop => ISR
+	struct tUsartRxRing rx;	// ISR => main loop
+	uint16_t txShift;		// data bits then stop bit, LSB goes next
+	uint8_t txTick;			// ticks till the next TX bit
+	uint8_t txBits;			// bits of the byte still to go out
+	volatile uint8_t txIdle;	// no byte on the line
+	uint8_t rxByte;
+	uint8_t rxTick;			// ticks till the next RX sample
+	uint8_t rxBits;			// 0 => waiting for a start bit
+	volatile uint8_t lost;
+	volatile uint8_t frameErr;
+} tUsart;
+/*----------------------------------------------------*/
+
+
+
+/******************* USER FUNCTIONS *******************/
+void tUSARTInit() {
+	cli();
+	tUsartTxRingInit(&tUsart.tx);
+	tUsartRxRingInit(&tUsart.rx);
+	tUsart.txTick = 0;
+	tUsart.txBits = 0;
+	tUsart.txIdle = 1;
+	tUsart.rxBits = 0;
+	tUsart.lost = 0;
+	tUsart.frameErr = 0;
+
+	TUSART_TX_PORT |= (1<<TUSART_TX_POS); // idle state is high
+	TUSART_TX_DDR |= (1<<TUSART_TX_POS);
+	TUSART_RX_DDR &= ~(1<<TUSART_RX_POS);
+	TUSART_RX_PORT |= (1<<TUSART_RX_POS); // pull up, line idles high
+
+	#if TUSART_TIMER == TUSART_T0
+		TCCR0 = (1<<WGM01) | TUSART_CS; // CTC
+		TCNT0 = 0;
+		OCR0 = TUSART_OCR;
+		TIFR = (1<<OCF0);
+		TIMSK |= (1<<OCIE0);
+	#else
+		TCCR2 = (1<<WGM21) | TUSART_CS; // CTC
+		TCNT2 = 0;
+		OCR2 = TUSART_OCR;
+		TIFR = (1<<OCF2);
+		TIMSK |= (1<<OCIE2);
+	#endif
+	sei();
+}
+
+
+void tUSARTStop() {
+	#if TUSART_TIMER == TUSART_T0
+		TIMSK &= ~(1<<OCIE0);
+		TCCR0 = 0;
+	#else
+		TIMSK &= ~(1<<OCIE2);
+		TCCR2 = 0;
+	#endif
+	TUSART_TX_PORT |= (1<<TUSART_TX_POS);
+	tUsart.txBits = 0;
+	tUsart.txIdle = 1;
+	tUsart.rxBits = 0;
+}
+
+
+uint8_t tUSARTWrite(uint8_t byte) {
+	while(!tUsartTxRingPush(&tUsart.tx, byte)) {
+		if(!(SREG & (1<<SREG_I))) {
+			return 0; // the ISR can not empty the ring
+		}
+	}
+	return 1;
+}
+
+
+void tUSARTPrint(const char *str) {
+	while(*str) {
+		tUSARTWrite(*str++);
+	}
+}
+
+
+void tUSARTSink(uint8_t c) {
+	tUSARTWrite(c);
+}
+
+#define tUSARTPrintf(fmt, ...) fmtPrint_P(tUSARTSink, PSTR(fmt), ##__VA_ARGS__)
+
+
+void tUSARTFlush() {
+	// the ISR pops a byte and clears txIdle in the same tick
+	while(tUsartTxRingCount(&tUsart.tx) || !tUsart.txIdle);
+}
+
+
+#define tUSARTAvailable() tUsartRxRingCount(&tUsart.rx)
+#define tUSARTRead(byte) tUsartRxRingPop(&tUsart.rx, (byte))
+/*-----------------------------------------------------*/
+
+
+
+/************************* ISR *************************/
+#if TUSART_TIMER == TUSART_T0
+	#ifdef ISR_DISPATCH
+		#define ISR_CLAIM_TIMER0_COMP
+		#include "../int/isr/isrClaim.h"
+		SHARED_ISR
+	#else
+		ISR(TIMER0_COMP_vect)
+	#endif
+#else
+	#ifdef ISR_DISPATCH
+		#define ISR_CLAIM_TIMER2_COMP
+		#include "../int/isr/isrClaim.h"
+		SHARED_ISR
+	#else
+		ISR(TIMER2_COMP_vect)
+	#endif
+#endif
+{
+	// pin first, so the sample point does not move with the TX work
+	uint8_t rx = TUSART_RX_PIN & (1<<TUSART_RX_POS);
+	uint8_t byte;
+
+	// TX, one bit every 3 ticks
+	if(tUsart.txTick) {
+		tUsart.txTick--;
+	}
+	else {
+		tUsart.txTick = 2;
+		if(tUsart.txBits) {
+			if(tUsart.txShift & 1) {
+				TUSART_TX_PORT |= (1<<TUSART_TX_POS);
+			}
+			else {
+				TUSART_TX_PORT &= ~(1<<TUSART_TX_POS);
+			}
+			tUsart.txShift >>= 1;
+			tUsart.txBits--;
+		}
+		else if(tUsartTxRingPop(&tUsart.tx, &byte)) {
+			TUSART_TX_PORT &= ~(1<<TUSART_TX_POS); // start bit
+			tUsart.txShift = byte | 0x100; // stop bit after the data
+			tUsart.txBits = 9;
+			tUsart.txIdle = 0;
+		}
+		else {
+			tUsart.txIdle = 1; // stop bit of the last byte is over
+		}
+	}
+
+	// RX
+	if(!tUsart.rxBits) {
+		if(!rx) {
+			// the edge came within the last tick, the middle
+			// of the start bit is 1 tick away
+			tUsart.rxBits = 10;
+			tUsart.rxTick = 1;
+		}
+	}
+	else if(!--tUsart.rxTick) {
+		tUsart.rxTick = 3;
+		if(tUsart.rxBits == 10) {
+			if(rx) {
+				tUsart.rxBits = 0; // glitch, not a start bit
+			}
+			else {
+				tUsart.rxBits--;
+			}
+		}
+		else if(tUsart.rxBits > 1) {
+			tUsart.rxByte >>= 1;
+			if(rx) {
+				tUsart.rxByte |= 0x80;
+			}
+			tUsart.rxBits--;
+		}
+		else {
+			// stop bit. Back to idle in its middle, so the next
+			// start bit is seen from its first tick
+			if(!rx) {
+				tUsart.frameErr++;
+			}
+			else if(!tUsartRxRingPush(&tUsart.rx, tUsart.rxByte)) {
+				tUsart.lost++;
+			}
+			tUsart.rxBits = 0;
+		}
+	}
+}
+/*-----------------------------------------------------*/
+
+
+
+/******************* EXAMPLE CODE *******************
+#include <avr/io.h>
+#include <util/delay.h>
+#include <avr/interrupt.h>
+#include "mega16/softUSART/softUSARTtimer.h"
+
+// echo on PD5 (TX) / PD6 (RX) while PA7 blinks
+int main() {
+	uint8_t c;
+	DDRA |= (1<<PA7);
+	tUSARTInit();
+	tUSARTPrintf("soft USART @ %u baud\r\n", TUSART_BAUD);
+
+	while(1) {
+		while(tUSARTRead(&c)) {
+			tUSARTWrite(c);
+		}
+		PORTA ^= (1<<PA7);
+		_delay_ms(100); // bytes keep coming in meanwhile
+	}
+}
+-----------------------------------------------------*/